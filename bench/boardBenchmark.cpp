@@ -0,0 +1,176 @@
+#include "benchmark/benchmark.h"
+#include "soko_board.hpp"
+#include "soko_position.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+using namespace Sokoban;
+using namespace std;
+
+/// Path of a shipped stage, relative to the build directory.
+static string stagePath(int stage) {
+  stringstream ss;
+  ss << "assets/stages/stage" << stage << ".sok";
+  return ss.str();
+}
+
+/// Temporary directory of the synthetic stages, made on first use and removed with them at exit.
+class SyntheticStages {
+  public:
+    SyntheticStages() {
+      char pattern[] = "/tmp/soko_bench_XXXXXX";
+      if (mkdtemp(pattern))
+        dir = pattern;
+    }
+
+    ~SyntheticStages() {
+      for (const string& path : paths)
+        remove(path.c_str());
+      if (!dir.empty())
+        remove(dir.c_str());
+    }
+
+    /// Return the path of the stage named @name, removed at exit.
+    string path(const string& name) {
+      string path = dir.empty() ? name : dir + "/" + name;
+      paths.insert(path);
+      return path;
+    }
+
+  private:
+    string dir;
+    set<string> paths;
+};
+
+/**
+Write a synthetic @size x @size stage in a temporary directory and return its path.
+The board is walled, with a row of light boxes and their targets every fourth row,
+and the character on the top left corner.
+*/
+static string syntheticStagePath(int size) {
+  static SyntheticStages stages;
+  stringstream name;
+  name << "bench_stage_" << size << ".sok";
+  string path = stages.path(name.str());
+
+  ofstream out(path.c_str());
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      SokoObject::Type type = SokoObject::EMPTY;
+      if (x == 0 || y == 0 || x == size - 1 || y == size - 1)
+        type = SokoObject::WALL;
+      else if (x == 1 && y == 1)
+        type = SokoObject::CHARACTER;
+      else if (y % 4 == 2 && x % 2 == 0 && x < size - 2)
+        type = SokoObject::LIGHT_BOX;
+      else if (y % 4 == 3 && x % 2 == 0 && x < size - 2)
+        type = SokoObject::TARGET;
+      out << (x ? " " : "") << type;
+    }
+    out << endl;
+  }
+  return path;
+}
+
+static void BM_ParseStage(benchmark::State& state) {
+  string path = stagePath(state.range(0));
+  for (auto _ : state) {
+    SokoBoard board(path);
+    benchmark::DoNotOptimize(board.getNumberOfBoxes());
+  }
+}
+BENCHMARK(BM_ParseStage)->DenseRange(1, 3);
+
+static void BM_ParseSynthetic(benchmark::State& state) {
+  string path = syntheticStagePath(state.range(0));
+  for (auto _ : state) {
+    SokoBoard board(path);
+    benchmark::DoNotOptimize(board.getNumberOfBoxes());
+  }
+  state.SetComplexityN(state.range(0) * state.range(0));
+}
+BENCHMARK(BM_ParseSynthetic)->RangeMultiplier(4)->Range(16, 256)->Complexity();
+
+/// A move followed by its undo, on the open top row of a synthetic board.
+static void BM_MoveUndo(benchmark::State& state) {
+  SokoBoard board(syntheticStagePath(state.range(0)));
+  for (auto _ : state) {
+    board.move(Direction::RIGHT);
+    board.undo();
+  }
+  state.SetItemsProcessed(2 * state.iterations());
+}
+BENCHMARK(BM_MoveUndo)->RangeMultiplier(4)->Range(16, 256);
+
+/// A box push followed by its undo.
+static void BM_PushUndo(benchmark::State& state) {
+  SokoBoard board(syntheticStagePath(state.range(0)));
+  board.move(Direction::RIGHT);
+  for (auto _ : state) {
+    board.move(Direction::DOWN);
+    board.undo();
+  }
+  state.SetItemsProcessed(2 * state.iterations());
+}
+BENCHMARK(BM_PushUndo)->RangeMultiplier(4)->Range(16, 256);
+
+/// getDynamic(x, y) over every cell of the board.
+static void BM_GetDynamicLookup(benchmark::State& state) {
+  SokoBoard board(syntheticStagePath(state.range(0)));
+  for (auto _ : state) {
+    for (unsigned y = 0; y < board.getNumberOfRows(); y++)
+      for (unsigned x = 0; x < board.getNumberOfColumns(); x++)
+        benchmark::DoNotOptimize(board.getDynamic(x, y).getType());
+  }
+  state.SetItemsProcessed(state.iterations() * board.getNumberOfRows() * board.getNumberOfColumns());
+}
+BENCHMARK(BM_GetDynamicLookup)->RangeMultiplier(4)->Range(16, 64);
+
+static void BM_ToString(benchmark::State& state) {
+  SokoBoard board(syntheticStagePath(state.range(0)));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(board.toString());
+}
+BENCHMARK(BM_ToString)->RangeMultiplier(4)->Range(16, 64);
+
+/// The 20 animation steps of a box push (the character and the box in flight), then the idle step.
+/// Only the objects in flight are visited: the time should not grow with the board.
+static void BM_Update(benchmark::State& state) {
+  SokoBoard board(syntheticStagePath(state.range(0)));
+  board.move(Direction::RIGHT);
+  board.update(1.0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    board.move(Direction::DOWN);
+    state.ResumeTiming();
+    while (board.isAnimating())
+      board.update(0.05);
+    board.update(0.05);
+    state.PauseTiming();
+    board.undo();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(21 * state.iterations());
+}
+BENCHMARK(BM_Update)->RangeMultiplier(4)->Range(16, 256);
+
+static void BM_StateHash(benchmark::State& state) {
+  SokoBoard board(state.range(0) ? syntheticStagePath(state.range(0)) : stagePath(3));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(board.getState().hash());
+}
+BENCHMARK(BM_StateHash)->Arg(0)->RangeMultiplier(4)->Range(16, 256);
+
+static void BM_StateSerialize(benchmark::State& state) {
+  SokoBoard board(syntheticStagePath(state.range(0)));
+  SokoState snapshot = board.getState();
+  for (auto _ : state)
+    benchmark::DoNotOptimize(snapshot.serialize(true));
+  state.counters["bytes"] = snapshot.serialize(true).size();
+}
+BENCHMARK(BM_StateSerialize)->RangeMultiplier(4)->Range(16, 256);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,42 @@
+#include "benchmark/benchmark.h"
+#include "mipmap.hpp"
+#include <cstdlib>
+
+using namespace Sokoban;
+
+namespace {
+  /// A noisy square RGBA image, the worst case for the filters.
+  Image noise(int size) {
+    Image image;
+    image.width = image.height = size;
+    image.pixels.resize(4 * size * size);
+    srand(size);
+    for (unsigned char& value : image.pixels)
+      value = rand() & 0xff;
+    return image;
+  }
+}
+
+/// Full mip chain of a size x size texture, box filtered.
+static void BM_MipmapsBox(benchmark::State& state) {
+  Image image = noise(state.range(0));
+  std::vector<Image> levels;
+  for (auto _ : state) {
+    buildMipmaps(image, levels, MIP_FILTER_BOX);
+    benchmark::DoNotOptimize(levels.data());
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * image.pixels.size());
+}
+BENCHMARK(BM_MipmapsBox)->Arg(256)->Arg(600)->Arg(1024)->Arg(2048)->Unit(benchmark::kMillisecond);
+
+/// Full mip chain of a size x size repeating texture, Kaiser filtered.
+static void BM_MipmapsKaiser(benchmark::State& state) {
+  Image image = noise(state.range(0));
+  std::vector<Image> levels;
+  for (auto _ : state) {
+    buildMipmaps(image, levels, MIP_FILTER_KAISER, true);
+    benchmark::DoNotOptimize(levels.data());
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * image.pixels.size());
+}
+BENCHMARK(BM_MipmapsKaiser)->Arg(256)->Arg(600)->Arg(1024)->Arg(2048)->Unit(benchmark::kMillisecond);
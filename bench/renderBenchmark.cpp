@@ -0,0 +1,34 @@
+#include "benchmark/benchmark.h"
+#include "game.hpp"
+#include "offscreen.hpp"
+#include "scene_renderer.hpp"
+
+using namespace Sokoban;
+
+/// A whole frame of stage 3 rendered offscreen, orbiting the camera. Arg: 0 fixed-function, 1 shaders.
+static void BM_RenderFrame(benchmark::State& state) {
+  OffscreenContext context;
+  if (!context.create(800, 600, state.range(0) == 0)) {
+    state.SkipWithError("No offscreen OpenGL context");
+    return;
+  }
+  if (state.range(0) == 1 && context.getRenderPath() != RENDER_PATH_SHADERS) {
+    state.SkipWithError("No OpenGL 3.3 core context");
+    return;
+  }
+  SceneRenderer* renderer = new SceneRenderer(NULL, 800, 600, NULL, NULL, NULL, NULL, context.getRenderPath());
+  Game game(renderer);
+  game.loadLevel(3);
+  game.waitForSimulation();
+
+  // Warm up: shaders and textures are only ready once something was drawn with them.
+  game.renderScene();
+  glFinish();
+  for (auto _ : state) {
+    renderer->getCamera().orbit(1, 0);
+    game.invalidate();
+    game.renderScene();
+    glFinish();
+  }
+}
+BENCHMARK(BM_RenderFrame)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
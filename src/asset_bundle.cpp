@@ -0,0 +1,102 @@
+#include "asset_bundle.hpp"
+#include "mipmap.hpp"
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Sokoban {
+
+AssetBundle::AssetBundle() {}
+
+AssetBundle::~AssetBundle() {
+  close();
+}
+
+bool AssetBundle::open(const std::string& path) {
+  close();
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat info;
+  if (fstat(fd, &info) < 0 || info.st_size < (off_t) sizeof(BundleHeader)) {
+    ::close(fd);
+    return false;
+  }
+  void* mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED)
+    return false;
+  data = (const unsigned char*) mapping;
+  size = info.st_size;
+
+  const BundleHeader* header = (const BundleHeader*) data;
+  if (memcmp(header->magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC)) != 0 || header->version != BUNDLE_VERSION ||
+      sizeof(BundleHeader) + uint64_t(header->entryCount) * sizeof(BundleEntry) > size) {
+    std::cout << "INFO: Invalid asset bundle " << path << std::endl;
+    close();
+    return false;
+  }
+
+  const BundleEntry* index = (const BundleEntry*) (data + sizeof(BundleHeader));
+  for (uint32_t i = 0; i < header->entryCount; i++) {
+    const BundleEntry& entry = index[i];
+    if (entry.offset > size || entry.size > size - entry.offset ||
+        memchr(entry.name, '\0', sizeof(entry.name)) == NULL) {
+      std::cout << "INFO: Invalid asset bundle " << path << std::endl;
+      close();
+      return false;
+    }
+    entries[std::make_pair(entry.type, std::string(entry.name))] = &entry;
+  }
+  return true;
+}
+
+void AssetBundle::close() {
+  if (data != NULL)
+    munmap((void*) data, size);
+  data = NULL;
+  size = 0;
+  entries.clear();
+}
+
+bool AssetBundle::isOpen() const {
+  return data != NULL;
+}
+
+const BundleEntry* AssetBundle::find(const std::string& name, BundleEntryType type) const {
+  auto it = entries.find(std::make_pair(uint32_t(type), name));
+  return it == entries.end() ? NULL : it->second;
+}
+
+const unsigned char* AssetBundle::getData(const BundleEntry& entry) const {
+  return data + entry.offset;
+}
+
+bool AssetBundle::getImage(const std::string& name, std::vector<MipLevel>& levels) const {
+  const BundleEntry* entry = find(name, BUNDLE_IMAGE);
+  if (entry == NULL)
+    return false;
+
+  levels.clear();
+  MipLevel level;
+  level.width = entry->info[0];
+  level.height = entry->info[1];
+  level.pixels = getData(*entry);
+  uint64_t used = 0;
+  for (uint32_t i = 0; i < entry->info[2]; i++) {
+    used += 4 * uint64_t(level.width) * level.height;
+    if (used > entry->size)
+      return false;
+    levels.push_back(level);
+    level.pixels += 4 * level.width * level.height;
+    level.width = nextMipSize(level.width);
+    level.height = nextMipSize(level.height);
+  }
+  return !levels.empty();
+}
+
+}
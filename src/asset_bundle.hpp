@@ -0,0 +1,93 @@
+#ifndef _ASSET_BUNDLE_H_
+#define _ASSET_BUNDLE_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "texture_cache.hpp"
+
+namespace Sokoban {
+  /// Kinds of assets stored in a bundle.
+  enum BundleEntryType {
+    BUNDLE_IMAGE = 0,
+    BUNDLE_SOUND = 1,
+    BUNDLE_FONT = 2,
+    BUNDLE_FILE = 3
+  };
+
+  /// Header at the start of a bundle file, followed by the index.
+  struct BundleHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+  };
+
+  /**
+  An entry of the bundle index. The meaning of @info depends on the type:
+  - image: width, height and number of mip levels, stored level 0 first as tightly packed RGBA;
+  - sound: frequency, SDL audio format and channels of the PCM samples;
+  - font: width, height and line height of the glyph atlas, stored as the glyph table then RGBA;
+  - file: unused, the raw bytes of the file.
+  */
+  struct BundleEntry {
+    char name[112];
+    uint32_t type;
+    uint32_t info[3];
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  const char BUNDLE_MAGIC[4] = {'S', 'O', 'K', 'B'};
+  const uint32_t BUNDLE_VERSION = 1;
+
+  /// Alignment of the data of every entry, from the start of the file.
+  const uint64_t BUNDLE_ALIGNMENT = 16;
+
+  /**
+  Read-only view of an asset bundle written by the bundler tool. The file is
+  memory mapped, so assets are used straight from the mapping without
+  decoding or copying. Bundles are in native byte order: they are built
+  on the machine that runs the game.
+  */
+  class AssetBundle {
+    public:
+      AssetBundle();
+
+      /// Unmap the bundle.
+      ~AssetBundle();
+
+      /// Map the bundle at @path. Returns false if it is missing or invalid.
+      bool open(const std::string& path);
+
+      /// Unmap the bundle. Pointers to its data become invalid.
+      void close();
+
+      /// Return true if a bundle is mapped.
+      bool isOpen() const;
+
+      /// Return the entry @name of the given type, or NULL.
+      const BundleEntry* find(const std::string& name, BundleEntryType type) const;
+
+      /// Return the data of @entry.
+      const unsigned char* getData(const BundleEntry& entry) const;
+
+      /// Fill @levels with the mip chain of the image @name. Returns false if it is not there.
+      bool getImage(const std::string& name, std::vector<MipLevel>& levels) const;
+
+    private:
+      AssetBundle(const AssetBundle&);
+      AssetBundle& operator=(const AssetBundle&);
+
+      /// The mapping and its size.
+      const unsigned char* data = NULL;
+      size_t size = 0;
+
+      /// Index entries by type and name.
+      std::map<std::pair<uint32_t, std::string>, const BundleEntry*> entries;
+  };
+}
+
+#endif // _ASSET_BUNDLE_H_
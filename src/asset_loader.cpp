@@ -0,0 +1,185 @@
+#include "asset_loader.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace Sokoban {
+
+namespace {
+  bool readFile(const std::string& path, std::vector<unsigned char>& bytes) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file.is_open())
+      return false;
+    bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+  }
+}
+
+bool loadSound(const std::string& path, int frequency, Uint16 format, int channels, Sound& sound) {
+  SDL_AudioSpec spec;
+  Uint8* buffer = NULL;
+  Uint32 length = 0;
+  if (SDL_LoadWAV_RW(SDL_RWFromFile(path.c_str(), "rb"), 1, &spec, &buffer, &length) == NULL)
+    return false;
+
+  SDL_AudioCVT cvt;
+  int needed = SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, format, channels, frequency);
+  if (needed < 0) {
+    SDL_FreeWAV(buffer);
+    return false;
+  }
+  if (needed == 0) {
+    sound.samples.assign(buffer, buffer + length);
+  }
+  else {
+    std::vector<Uint8> converted(length * cvt.len_mult);
+    memcpy(converted.data(), buffer, length);
+    cvt.buf = converted.data();
+    cvt.len = length;
+    if (SDL_ConvertAudio(&cvt) < 0) {
+      SDL_FreeWAV(buffer);
+      return false;
+    }
+    converted.resize(cvt.len_cvt);
+    sound.samples.swap(converted);
+  }
+  SDL_FreeWAV(buffer);
+  return true;
+}
+
+AssetLoader::AssetLoader(unsigned threads) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  for (unsigned i = 0; i < threads; i++)
+    workers.push_back(std::thread(&AssetLoader::work, this));
+}
+
+AssetLoader::~AssetLoader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+    tasks.clear();
+  }
+  taskAvailable.notify_all();
+  for (std::thread& worker : workers)
+    worker.join();
+}
+
+void AssetLoader::enqueue(const std::function<void()>& task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.push_back(task);
+  }
+  taskAvailable.notify_one();
+}
+
+void AssetLoader::work() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+    if (stopping)
+      return;
+
+    std::function<void()> task = tasks.front();
+    tasks.pop_front();
+    running++;
+    lock.unlock();
+    task();
+    lock.lock();
+    running--;
+    taskFinished.notify_all();
+  }
+}
+
+void AssetLoader::requestImage(const std::string& path) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (images.count(path))
+      return;
+    images[path];
+  }
+  enqueue([this, path] {
+    Image image;
+    bool ok = loadImage(path, image);
+    std::lock_guard<std::mutex> lock(mutex);
+    Result<Image>& result = images[path];
+    result.value.width = image.width;
+    result.value.height = image.height;
+    result.value.pixels.swap(image.pixels);
+    result.ok = ok;
+    result.done = true;
+  });
+}
+
+void AssetLoader::requestSound(const std::string& path, int frequency, Uint16 format, int channels) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (sounds.count(path))
+      return;
+    sounds[path];
+  }
+  enqueue([this, path, frequency, format, channels] {
+    Sound sound;
+    bool ok = loadSound(path, frequency, format, channels, sound);
+    std::lock_guard<std::mutex> lock(mutex);
+    Result<Sound>& result = sounds[path];
+    result.value.samples.swap(sound.samples);
+    result.ok = ok;
+    result.done = true;
+  });
+}
+
+void AssetLoader::requestFile(const std::string& path) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (files.count(path))
+      return;
+    files[path];
+  }
+  enqueue([this, path] {
+    std::vector<unsigned char> bytes;
+    bool ok = readFile(path, bytes);
+    std::lock_guard<std::mutex> lock(mutex);
+    Result< std::vector<unsigned char> >& result = files[path];
+    result.value.swap(bytes);
+    result.ok = ok;
+    result.done = true;
+  });
+}
+
+bool AssetLoader::isDone() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return tasks.empty() && running == 0;
+}
+
+template <typename T>
+bool AssetLoader::take(std::unique_lock<std::mutex>& lock, std::map< std::string, Result<T> >& results,
+                       const std::string& path, T& value) {
+  auto it = results.find(path);
+  if (it == results.end())
+    return false;
+  taskFinished.wait(lock, [&it] { return it->second.done; });
+  bool ok = it->second.ok;
+  if (ok)
+    std::swap(value, it->second.value);
+  results.erase(it);
+  return ok;
+}
+
+bool AssetLoader::takeImage(const std::string& path, Image& image) {
+  std::unique_lock<std::mutex> lock(mutex);
+  return take(lock, images, path, image);
+}
+
+bool AssetLoader::takeSound(const std::string& path, Sound& sound) {
+  std::unique_lock<std::mutex> lock(mutex);
+  return take(lock, sounds, path, sound);
+}
+
+bool AssetLoader::takeFile(const std::string& path, std::vector<unsigned char>& bytes) {
+  std::unique_lock<std::mutex> lock(mutex);
+  return take(lock, files, path, bytes);
+}
+
+}
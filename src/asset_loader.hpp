@@ -0,0 +1,97 @@
+#ifndef _ASSET_LOADER_H_
+#define _ASSET_LOADER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "texture_cache.hpp"
+
+namespace Sokoban {
+  /// A sound decoded to PCM, in the format of the audio device.
+  struct Sound {
+    std::vector<Uint8> samples;
+  };
+
+  /// Decode the WAV file at @path to PCM in the given format. Returns false if it could not be loaded.
+  bool loadSound(const std::string& path, int frequency, Uint16 format, int channels, Sound& sound);
+
+  /**
+  Decodes assets on a pool of background threads.
+
+  Requests are queued from the main thread; results are kept until the main
+  thread takes them, which is where anything touching OpenGL or SDL_mixer
+  happens. Taking a result that is still being decoded waits for it.
+  */
+  class AssetLoader {
+    public:
+      /// Start @threads workers (0: one per hardware thread).
+      explicit AssetLoader(unsigned threads = 0);
+
+      /// Wait for the workers to finish the current task and stop them. Pending requests are dropped.
+      ~AssetLoader();
+
+      /// Queue the decoding of the image at @path to RGBA.
+      void requestImage(const std::string& path);
+
+      /// Queue the decoding of the WAV file at @path to the given device format.
+      void requestSound(const std::string& path, int frequency, Uint16 format, int channels);
+
+      /// Queue reading the raw bytes of the file at @path.
+      void requestFile(const std::string& path);
+
+      /// Return true when every queued request has been processed.
+      bool isDone() const;
+
+      /// Take the image decoded from @path. Returns false if it was not requested or failed.
+      bool takeImage(const std::string& path, Image& image);
+
+      /// Take the sound decoded from @path. Returns false if it was not requested or failed.
+      bool takeSound(const std::string& path, Sound& sound);
+
+      /// Take the bytes read from @path. Returns false if it was not requested or failed.
+      bool takeFile(const std::string& path, std::vector<unsigned char>& bytes);
+
+    private:
+      AssetLoader(const AssetLoader&);
+      AssetLoader& operator=(const AssetLoader&);
+
+      /// A decoding result: whether it is finished and whether it succeeded.
+      template <typename T>
+      struct Result {
+        bool done = false;
+        bool ok = false;
+        T value;
+      };
+
+      /// Queue @task for the workers.
+      void enqueue(const std::function<void()>& task);
+
+      /// Body of each worker thread.
+      void work();
+
+      /// Wait until @results[path] is done, then move it out. Called with @lock held.
+      template <typename T>
+      bool take(std::unique_lock<std::mutex>& lock, std::map< std::string, Result<T> >& results,
+            const std::string& path, T& value);
+
+      mutable std::mutex mutex;
+      std::condition_variable taskAvailable;
+      std::condition_variable taskFinished;
+      std::deque< std::function<void()> > tasks;
+      unsigned running = 0;
+      bool stopping = false;
+      std::vector<std::thread> workers;
+
+      std::map< std::string, Result<Image> > images;
+      std::map< std::string, Result<Sound> > sounds;
+      std::map< std::string, Result< std::vector<unsigned char> > > files;
+  };
+}
+
+#endif // _ASSET_LOADER_H_
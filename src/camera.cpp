@@ -0,0 +1,219 @@
+#include "camera.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace Sokoban {
+
+namespace {
+  /// Default view: from (4, 4, 4), looking at the origin.
+  const double DEFAULT_YAW = 45.0;
+  const double DEFAULT_PITCH = 35.2643896828;
+  const double DEFAULT_DISTANCE = 6.92820323028;
+
+  /// Degrees of orbit per dragged pixel.
+  const double ORBIT_SPEED = 0.25;
+
+  /// Target displacement per dragged pixel, relative to the distance.
+  const double PAN_SPEED = 0.002;
+
+  /// Pitch limits, so the camera never flips over the poles.
+  const double MIN_PITCH = -89.0;
+  const double MAX_PITCH = 89.0;
+
+  const double DEGREES = 3.14159265358979323846 / 180.0;
+}
+
+void Frustum::extract(const double* clip) {
+  // Each plane is the last row of the matrix plus or minus one of the others.
+  for (int i = 0; i < 6; i++) {
+    int row = i / 2;
+    double sign = i % 2 == 0 ? 1.0 : -1.0;
+    for (int j = 0; j < 4; j++)
+      planes[i][j] = clip[4 * j + 3] + sign * clip[4 * j + row];
+    double length = sqrt(planes[i][0] * planes[i][0] + planes[i][1] * planes[i][1] + planes[i][2] * planes[i][2]);
+    if (length > 0.0)
+      for (int j = 0; j < 4; j++)
+        planes[i][j] /= length;
+  }
+}
+
+bool Frustum::intersects(const float min[3], const float max[3]) const {
+  // The box is out if its corner furthest along a plane normal is behind that plane.
+  for (int i = 0; i < 6; i++) {
+    const double* p = planes[i];
+    double distance = p[3];
+    for (int j = 0; j < 3; j++)
+      distance += p[j] * (p[j] >= 0.0 ? max[j] : min[j]);
+    if (distance < 0.0)
+      return false;
+  }
+  return true;
+}
+
+Camera::Camera() {
+  std::fill(viewMatrix, viewMatrix + 16, 0.0);
+  setPerspective(65.0, 4.0 / 3.0, 1.0, 10.0);
+  reset();
+}
+
+void Camera::reset() {
+  yaw = DEFAULT_YAW;
+  pitch = DEFAULT_PITCH;
+  distance = DEFAULT_DISTANCE;
+  scale = 1.0;
+  target[0] = target[1] = target[2] = 0.0;
+  pendingOrbit[0] = pendingOrbit[1] = 0.0;
+  pendingPan[0] = pendingPan[1] = 0.0;
+  pendingZoom = 1.0;
+  buildViewMatrix();
+}
+
+void Camera::orbit(double dx, double dy) {
+  pendingOrbit[0] += dx;
+  pendingOrbit[1] += dy;
+}
+
+void Camera::pan(double dx, double dy) {
+  pendingPan[0] += dx;
+  pendingPan[1] += dy;
+}
+
+void Camera::zoom(int direction) {
+  pendingZoom *= direction == 1 ? 1.05 : 0.95;
+}
+
+bool Camera::update() {
+  if (pendingOrbit[0] == 0.0 && pendingOrbit[1] == 0.0 &&
+      pendingPan[0] == 0.0 && pendingPan[1] == 0.0 && pendingZoom == 1.0)
+    return false;
+
+  yaw = fmod(yaw - pendingOrbit[0] * ORBIT_SPEED, 360.0);
+  if (yaw < 0.0)
+    yaw += 360.0;
+  pitch = std::min(MAX_PITCH, std::max(MIN_PITCH, pitch + pendingOrbit[1] * ORBIT_SPEED));
+
+  // Drags move the board under the cursor: right along the screen, down away from the eye.
+  double step = PAN_SPEED * distance;
+  double c = cos(yaw * DEGREES), s = sin(yaw * DEGREES);
+  target[0] += (s * pendingPan[0] - c * pendingPan[1]) * step;
+  target[1] += (-c * pendingPan[0] - s * pendingPan[1]) * step;
+
+  scale *= pendingZoom;
+
+  pendingOrbit[0] = pendingOrbit[1] = 0.0;
+  pendingPan[0] = pendingPan[1] = 0.0;
+  pendingZoom = 1.0;
+  buildViewMatrix();
+  return true;
+}
+
+void Camera::buildViewMatrix() {
+  // Same as gluLookAt(eye, target, z up) followed by glScaled(scale).
+  double cp = cos(pitch * DEGREES), sp = sin(pitch * DEGREES);
+  double cy = cos(yaw * DEGREES), sy = sin(yaw * DEGREES);
+  double eye[3] = {
+    target[0] + distance * cp * cy,
+    target[1] + distance * cp * sy,
+    target[2] + distance * sp
+  };
+  double f[3] = {-cp * cy, -cp * sy, -sp};
+  double r[3] = {-sy, cy, 0.0};                  // f x (0, 0, 1), normalized
+  double u[3] = {-sp * cy, -sp * sy, cp};        // r x f
+
+  double* m = viewMatrix;
+  for (int i = 0; i < 3; i++) {
+    m[4 * i + 0] = r[i] * scale;
+    m[4 * i + 1] = u[i] * scale;
+    m[4 * i + 2] = -f[i] * scale;
+    m[4 * i + 3] = 0.0;
+  }
+  m[12] = -(r[0] * eye[0] + r[1] * eye[1] + r[2] * eye[2]);
+  m[13] = -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]);
+  m[14] = f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2];
+  m[15] = 1.0;
+  buildFrustum();
+}
+
+void Camera::setPerspective(double fovy, double aspect, double zNear, double zFar) {
+  double f = 1.0 / tan(fovy * DEGREES / 2.0);
+  double* m = projectionMatrix;
+  std::fill(m, m + 16, 0.0);
+  m[0] = f / aspect;
+  m[5] = f;
+  m[10] = (zFar + zNear) / (zNear - zFar);
+  m[11] = -1.0;
+  m[14] = 2.0 * zFar * zNear / (zNear - zFar);
+  buildFrustum();
+}
+
+void Camera::buildFrustum() {
+  double clip[16];
+  for (int column = 0; column < 4; column++)
+    for (int row = 0; row < 4; row++) {
+      clip[4 * column + row] = 0.0;
+      for (int k = 0; k < 4; k++)
+        clip[4 * column + row] += projectionMatrix[4 * k + row] * viewMatrix[4 * column + k];
+    }
+  frustum.extract(clip);
+}
+
+const double* Camera::getViewMatrix() const {
+  return viewMatrix;
+}
+
+const double* Camera::getProjectionMatrix() const {
+  return projectionMatrix;
+}
+
+const Frustum& Camera::getFrustum() const {
+  return frustum;
+}
+
+double Camera::getYaw() const {
+  return yaw;
+}
+
+double Camera::getPitch() const {
+  return pitch;
+}
+
+double Camera::getDistance() const {
+  return distance;
+}
+
+double Camera::getScale() const {
+  return scale;
+}
+
+const double* Camera::getTarget() const {
+  return target;
+}
+
+std::string Camera::serialize() const {
+  std::ostringstream out;
+  out.precision(17);
+  out << "camera " << yaw << " " << pitch << " " << distance << " " << scale << " "
+      << target[0] << " " << target[1] << " " << target[2];
+  return out.str();
+}
+
+bool Camera::deserialize(const std::string& text, Camera& camera) {
+  std::istringstream in(text);
+  std::string tag;
+  double yaw, pitch, distance, scale, target[3];
+  if (!(in >> tag >> yaw >> pitch >> distance >> scale >> target[0] >> target[1] >> target[2]) ||
+      tag != "camera" || !(distance > 0.0) || !(scale > 0.0) || pitch < MIN_PITCH || pitch > MAX_PITCH)
+    return false;
+
+  camera.reset();
+  camera.yaw = yaw;
+  camera.pitch = pitch;
+  camera.distance = distance;
+  camera.scale = scale;
+  std::copy(target, target + 3, camera.target);
+  camera.buildViewMatrix();
+  return true;
+}
+
+}
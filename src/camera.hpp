@@ -0,0 +1,95 @@
+#ifndef _CAMERA_H_
+#define _CAMERA_H_
+
+#include <string>
+
+namespace Sokoban {
+  /// The six planes (left, right, bottom, top, near, far) bounding what a camera sees.
+  struct Frustum {
+    /// Plane equations a x + b y + c z + d >= 0 for the inside, normalized.
+    double planes[6][4];
+
+    /// Extract the planes from a column-major projection * view matrix.
+    void extract(const double* clip);
+
+    /// Return false if the axis-aligned box [@min, @max] is entirely outside.
+    bool intersects(const float min[3], const float max[3]) const;
+  };
+
+  /**
+  Orbit camera looking at the board: yaw and pitch around a target point, a
+  distance from it and a zoom (scale) factor.
+
+  Input is only accumulated by orbit(), pan() and zoom(); update() folds it in
+  and builds the view matrix once per frame, so the camera state never lives
+  in (nor drifts with) the OpenGL matrix stack and can be serialized.
+  */
+  class Camera {
+    public:
+      /// Constructs the default view of the board.
+      Camera();
+
+      /// Go back to the default view, dropping any pending input.
+      void reset();
+
+      /// Orbit around the target by a mouse drag of @dx x @dy pixels.
+      void orbit(double dx, double dy);
+
+      /// Move the target in the board plane by a mouse drag of @dx x @dy pixels.
+      void pan(double dx, double dy);
+
+      /// Zoom in (1) or out (-1).
+      void zoom(int direction);
+
+      /// Apply the input accumulated since the last call. Returns true if the view changed.
+      bool update();
+
+      /// Set the perspective projection, as gluPerspective() does.
+      void setPerspective(double fovy, double aspect, double zNear, double zFar);
+
+      /// Column-major view matrix (scale included) as of the last update(), for glLoadMatrixd().
+      const double* getViewMatrix() const;
+
+      /// Column-major projection matrix, for glLoadMatrixd().
+      const double* getProjectionMatrix() const;
+
+      /// The view frustum, in board coordinates, as of the last update().
+      const Frustum& getFrustum() const;
+
+      /// Angles (in degrees), distance to the target and scale factor.
+      double getYaw() const;
+      double getPitch() const;
+      double getDistance() const;
+      double getScale() const;
+
+      /// The point the camera looks at.
+      const double* getTarget() const;
+
+      /// Serialize the camera state (pending input excluded) to a line of text.
+      std::string serialize() const;
+
+      /// Build a camera back from the text produced by serialize(). Returns false on malformed input.
+      static bool deserialize(const std::string& text, Camera& camera);
+
+    private:
+      /// Rebuild the view matrix (and the frustum) from the current state.
+      void buildViewMatrix();
+
+      /// Rebuild the frustum from the view and projection matrices.
+      void buildFrustum();
+
+      double yaw, pitch, distance, scale;
+      double target[3];
+
+      /// Input not applied yet: orbit and pan in pixels, zoom as a factor.
+      double pendingOrbit[2];
+      double pendingPan[2];
+      double pendingZoom;
+
+      double viewMatrix[16];
+      double projectionMatrix[16];
+      Frustum frustum;
+  };
+}
+
+#endif // _CAMERA_H_
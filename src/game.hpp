@@ -4,70 +4,96 @@
 #include <cmath>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 #include <string>
 #include <sstream>
-#include <GL/glu.h>
-#include <iostream>
+#include "profiler.hpp"
+#include "renderer.hpp"
+#include "simulation.hpp"
 #include "soko_board.hpp"
-#include <SOIL/SOIL.h>
-#include <SDL2/SDL.h>
-#include <SDL2/SDL_image.h>
-#include <SDL2/SDL_opengl.h>
-#include <SDL2/SDL_ttf.h>
 
 namespace Sokoban {
   class Game {
     public:
-      Game(SDL_Window*, SDL_GLContext*, int screenWidth, 
-            int screenHeight, TTF_Font* windowFont, 
-            SDL_Renderer* windowRenderer);
+      /// Run the game logic and draw it with @renderer, which the game takes ownership of.
+      explicit Game(Renderer* renderer);
       ~Game();
 
-      /// Load the specified @level.
+      /// Load the specified @level. The board is parsed on the simulation thread and shown once it is published.
       void loadLevel(const unsigned level);
 
+      /// Load the board in @path, shown as @level.
+      void loadLevel(const unsigned level, const std::string& path);
+
+      /// Parse the specified @level in the background and prepare its rendering, so loading it next is instant.
+      void preloadLevel(const unsigned level);
+
+      /// Block until the simulation applied everything queued so far and its animations are over.
+      void waitForSimulation();
+
       /// Set the window size to @width x @height.
       void setWindowSize(unsigned width, unsigned height);
 
-      void setOldPosition(GLdouble x, GLdouble y);
-      void setNewPosition(GLdouble xnew, GLdouble ynew);
+      /// Anchor a mouse drag at @x, @y.
+      void setOldPosition(double x, double y);
 
-      /// Return true if the current level has been finished.
+      /// Drag the mouse to @xnew, @ynew: orbits the view, or pans it if @pan.
+      void setNewPosition(double xnew, double ynew, bool pan = false);
+
+      /// Return true if the current level has been finished, as of the last rendered snapshot.
       bool isLevelFinished() const;
 
-      /// Action of the move down key.
-      bool moveDownAction();
+      /// Action of the move down key. Queued to the simulation, see takeEvents() for its outcome.
+      /// Moves repeat until their key is released, see releaseMoveAction().
+      void moveDownAction();
 
       /// Action of the move up key.
-      bool moveUpAction();
+      void moveUpAction();
 
       /// Action of the move left key.
-      bool moveLeftAction();
+      void moveLeftAction();
 
       /// Action of the move right key.
-      bool moveRightAction();
+      void moveRightAction();
+
+      /// Action of releasing the key of the move to @direction.
+      void releaseMoveAction(Direction direction);
 
       /// Undo action.
-      bool undoAction();
+      void undoAction();
+
+      /// Repeat held moves after @delay seconds, then every @interval; with @coalesce, walks are animated faster.
+      void setInput(double delay, double interval, bool coalesce);
+
+      /// Animate the next moves over @duration seconds (none if not positive) with @easing.
+      void setAnimation(double duration, Easing easing);
 
-      /// Draws a cube of size edge centered at (x,y,z).
-      void drawCube(GLdouble x, GLdouble y, GLdouble z, 
-            GLdouble edge, GLuint* textureIDs);
+      /// Move what the board did since the last call (moves, boxes pushed, targets reached) to @events.
+      void takeEvents(std::vector<SokoEvent>& events);
 
-      /// Reshape function.
-      void sokoReshape();
+      /// Call @listener from the simulation thread whenever a new snapshot is ready to be rendered.
+      void setSnapshotListener(const std::function<void()>& listener);
 
-      /// Main function to render a scene.
+      /// Main function to render a scene, from the latest board snapshot.
       void renderScene();
 
+      /// Return true if the view changed or a new snapshot was published since the last renderScene().
+      bool needsRedraw() const;
+
+      /// Force the next frame to be rendered (eg. the window was exposed).
+      void invalidate();
+
       /// Render a single image, at the given path.
       void renderSingleImage(const char* path);
 
-      /// Render the status bar.
-      void renderStatusbar(std::string text, SDL_Color textColor);
+      /// Show or hide the frame time percentiles over the top of the window.
+      void setProfilerOverlay(bool visible);
 
-      /// Get the game board.
-      SokoBoard* getGameBoard() const;
+      /// Return true if the frame time percentiles are shown.
+      bool isProfilerOverlayVisible() const;
+
+      /// Get the board snapshot of the last rendered frame.
+      const BoardSnapshot& getSnapshot() const;
 
       /// Get the current game level.
       unsigned getCurrentLevel() const;
@@ -75,51 +101,44 @@ namespace Sokoban {
       /// Change the game scale. 1 = should increase and -1 should decrease.
       void changeScale(int);
 
-    private:
-      /// Main SDL window.
-      SDL_Window* window;
-
-      /// The OpenGL context from SDL.
-      SDL_GLContext* glContext;
-
-      int screenWidth, screenHeight;
+      /// Get the renderer the game draws with.
+      Renderer& getRenderer();
 
-      /// The current game level.
-      unsigned currentLevel;
-
-      /// The window font (TTF).
-      TTF_Font* windowFont;
+    private:
+      /// Path of the board of @level.
+      static std::string levelPath(const unsigned level);
 
-      /// The main window renderer.
-      SDL_Renderer* windowRenderer;
+      /// Rebuild the status bar text if the board changed since it was last built.
+      void updateStatusbar();
 
-      /// The current soko board
-      SokoBoard *board = NULL;
+      /// The frame time percentiles of the last frames.
+      std::string profilerText() const;
 
-      GLdouble xold, yold;
+      /// The current game level, as last requested.
+      unsigned currentLevel = 0;
 
-      /// The game scale (zoom) factor.
-      double scale = 1.0;
+      /// Runs the board on its own thread and publishes snapshots of it.
+      Simulation simulation;
 
-      const char* targetPath[6] = {"assets/wall_top.jpg", "assets/x.png", "assets/x.png", "assets/x.png", "assets/x.png", "assets/x.png"};
-      GLuint textureTargetIDs[6];
+      /// Draws the snapshots.
+      std::unique_ptr<Renderer> renderer;
 
-      const char* characterPath[6] = {"assets/claudio.jpg", "assets/claudio.jpg", "assets/claudio.jpg", "assets/claudio.jpg", "assets/claudio.jpg", "assets/claudio.jpg"};
-      GLuint textureCharacterIDs[6];
+      /// Board changes the status bar was last built for.
+      unsigned statusbarChanges = 0;
 
-      const char* lightBoxPath[6] = {"assets/wood.png", "assets/wood.png", "assets/wood.png", "assets/wood.png", "assets/wood.png", "assets/wood.png"};
-      GLuint textureLightBoxIDs[6];
+      /// Text drawn over the board.
+      HudText hud;
 
-      const char* heavyBoxPath[6] = {"assets/stone.png", "assets/stone.png", "assets/stone.png", "assets/stone.png", "assets/stone.png", "assets/stone.png"};
-      GLuint textureHeavyBoxIDs[6];
+      /// Whether the frame time percentiles are shown.
+      bool profilerOverlay = false;
 
-      const char* wallPath[6] = {"assets/wall_top.jpg", "assets/wall_top.jpg", "assets/wall.jpg", "assets/wall.jpg", "assets/wall.jpg", "assets/wall.jpg"};
-      GLuint textureWallIDs[6];
+      /// Number of latest frames the percentiles are computed over.
+      const unsigned PROFILER_FRAMES = 240;
 
-      const char* floorPath[6] = {"assets/wall_top.jpg", "assets/floor.jpg", "assets/wall.jpg", "assets/wall.jpg", "assets/wall.jpg", "assets/wall.jpg"};
-      GLuint textureFloorIDs[6];
+      double xold, yold;
 
-      GLfloat color[4] = {1.0, 1.0, 1.0, 1.0};
+      /// Set when the view or status bar changed since the last frame.
+      bool dirty = true;
   };
 }
 
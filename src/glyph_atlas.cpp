@@ -0,0 +1,153 @@
+#include "glyph_atlas.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace Sokoban {
+
+namespace {
+  /// Width of the atlas texture, in pixels.
+  const int ATLAS_WIDTH = 1024;
+
+  int nextPowerOfTwo(int n) {
+    int p = 1;
+    while (p < n)
+      p *= 2;
+    return p;
+  }
+}
+
+GlyphAtlas::GlyphAtlas() {}
+
+GlyphAtlas::~GlyphAtlas() {
+  if (texture != 0)
+    glDeleteTextures(1, &texture);
+}
+
+bool GlyphAtlas::build(TTF_Font* font) {
+  Image atlas;
+  if (!rasterize(font, atlas))
+    return false;
+  upload(atlas.pixels.data(), atlas.width, atlas.height);
+  return true;
+}
+
+bool GlyphAtlas::build(const AssetBundle& bundle, const std::string& name) {
+  const BundleEntry* entry = bundle.find(name, BUNDLE_FONT);
+  const unsigned count = LAST_CHAR - FIRST_CHAR + 1;
+  if (entry == NULL || entry->size != count * sizeof(Glyph) + 4 * uint64_t(entry->info[0]) * entry->info[1])
+    return false;
+
+  const Glyph* table = (const Glyph*) bundle.getData(*entry);
+  glyphs.assign(table, table + count);
+  height = entry->info[2];
+  upload((const unsigned char*) (table + count), entry->info[0], entry->info[1]);
+  return true;
+}
+
+bool GlyphAtlas::rasterize(TTF_Font* font, Image& atlas) {
+  const SDL_Color white = {255, 255, 255, 255};
+  std::vector<SDL_Surface*> surfaces;
+
+  // Render each glyph alone, as a one letter string, so it keeps the same
+  // bearing and advance it gets from TTF_RenderText_*().
+  for (char c = FIRST_CHAR; c <= LAST_CHAR; c++) {
+    char text[2] = {c, '\0'};
+    SDL_Surface* rendered = TTF_RenderText_Blended(font, text, white);
+    SDL_Surface* surface = rendered ? SDL_ConvertSurfaceFormat(rendered, SDL_PIXELFORMAT_RGBA32, 0) : NULL;
+    SDL_FreeSurface(rendered);
+    if (surface == NULL) {
+      for (SDL_Surface* s : surfaces)
+        SDL_FreeSurface(s);
+      return false;
+    }
+    surfaces.push_back(surface);
+  }
+
+  // Shelf packing, one row of glyphs after the other.
+  height = TTF_FontHeight(font);
+  std::vector<int> xs, ys;
+  int x = 0, y = 0;
+  for (SDL_Surface* surface : surfaces) {
+    if (x + surface->w > ATLAS_WIDTH) {
+      x = 0;
+      y += height + 1;
+    }
+    xs.push_back(x);
+    ys.push_back(y);
+    x += surface->w + 1;
+  }
+  int atlasHeight = nextPowerOfTwo(y + height);
+
+  atlas.width = ATLAS_WIDTH;
+  atlas.height = atlasHeight;
+  atlas.pixels.assign(4 * ATLAS_WIDTH * atlasHeight, 0);
+  glyphs.clear();
+  for (unsigned i = 0; i < surfaces.size(); i++) {
+    SDL_Surface* surface = surfaces[i];
+    int rows = std::min(surface->h, height);
+    SDL_LockSurface(surface);
+    for (int row = 0; row < rows; row++)
+      memcpy(&atlas.pixels[4 * ((ys[i] + row) * ATLAS_WIDTH + xs[i])],
+             (unsigned char*) surface->pixels + row * surface->pitch, 4 * surface->w);
+    SDL_UnlockSurface(surface);
+
+    Glyph glyph = {
+      surface->w, rows,
+      GLfloat(xs[i]) / ATLAS_WIDTH, GLfloat(ys[i]) / atlasHeight,
+      GLfloat(xs[i] + surface->w) / ATLAS_WIDTH, GLfloat(ys[i] + rows) / atlasHeight
+    };
+    glyphs.push_back(glyph);
+    SDL_FreeSurface(surface);
+  }
+  return true;
+}
+
+void GlyphAtlas::upload(const unsigned char* pixels, int atlasWidth, int atlasHeight) {
+  if (texture == 0)
+    glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, atlasWidth, atlasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+}
+
+int GlyphAtlas::layout(const std::string& text, std::vector<TextVertex>& vertices) const {
+  int x = 0;
+  for (char c : text) {
+    if (c < FIRST_CHAR || c > LAST_CHAR || glyphs.empty())
+      continue;
+    const Glyph& g = glyphs[c - FIRST_CHAR];
+    TextVertex quad[4] = {
+      {{GLfloat(x), 0}, {g.u0, g.v0}},
+      {{GLfloat(x + g.width), 0}, {g.u1, g.v0}},
+      {{GLfloat(x + g.width), GLfloat(g.height)}, {g.u1, g.v1}},
+      {{GLfloat(x), GLfloat(g.height)}, {g.u0, g.v1}}
+    };
+    vertices.insert(vertices.end(), quad, quad + 4);
+    x += g.width;
+  }
+  return x;
+}
+
+const std::vector<GlyphAtlas::Glyph>& GlyphAtlas::getGlyphs() const {
+  return glyphs;
+}
+
+std::string GlyphAtlas::bundleName(TTF_Font* font) {
+  const char* family = TTF_FontFaceFamilyName(font);
+  const char* style = TTF_FontFaceStyleName(font);
+  return std::string("font:") + (family ? family : "") + ":" + (style ? style : "") + ":" +
+         std::to_string(TTF_FontHeight(font));
+}
+
+int GlyphAtlas::getHeight() const {
+  return height;
+}
+
+GLuint GlyphAtlas::getTexture() const {
+  return texture;
+}
+
+}
@@ -0,0 +1,79 @@
+#ifndef _GLYPH_ATLAS_H_
+#define _GLYPH_ATLAS_H_
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <SDL2/SDL_ttf.h>
+#include "asset_bundle.hpp"
+
+namespace Sokoban {
+  /// A vertex of laid out text: position in pixels and texture coordinates in the atlas.
+  struct TextVertex {
+    GLfloat position[2];
+    GLfloat texCoord[2];
+  };
+
+  /**
+  All printable ASCII glyphs of a font, rendered once into a single texture,
+  so text can be drawn as textured quads without rasterizing it every frame.
+  */
+  class GlyphAtlas {
+    public:
+      /// A glyph: its size in pixels and its region in the atlas.
+      struct Glyph {
+        int width, height;
+        GLfloat u0, v0, u1, v1;
+      };
+
+      GlyphAtlas();
+
+      /// Delete the atlas texture.
+      ~GlyphAtlas();
+
+      /// Render the glyphs of @font (in white) and upload them. Returns false on failure.
+      bool build(TTF_Font* font);
+
+      /// Upload the glyphs prerendered in the font entry @name of @bundle. Returns false if it is not there.
+      bool build(const AssetBundle& bundle, const std::string& name);
+
+      /// Render the glyphs of @font into @atlas, without uploading it. Returns false on failure.
+      bool rasterize(TTF_Font* font, Image& atlas);
+
+      /// Return the glyphs, from the first to the last character.
+      const std::vector<Glyph>& getGlyphs() const;
+
+      /// Name of the glyphs of @font in an asset bundle.
+      static std::string bundleName(TTF_Font* font);
+
+      /// Append the quads of @text to @vertices, starting at (0,0), y down. Returns the text width.
+      int layout(const std::string& text, std::vector<TextVertex>& vertices) const;
+
+      /// Return the line height of the font, in pixels.
+      int getHeight() const;
+
+      /// Return the atlas texture.
+      GLuint getTexture() const;
+
+    private:
+      GlyphAtlas(const GlyphAtlas&);
+      GlyphAtlas& operator=(const GlyphAtlas&);
+
+      /// First and last characters of the atlas.
+      static const char FIRST_CHAR = ' ';
+      static const char LAST_CHAR = '~';
+
+      /// Upload @pixels as the atlas texture.
+      void upload(const unsigned char* pixels, int atlasWidth, int atlasHeight);
+
+      std::vector<Glyph> glyphs;
+
+      /// Line height, in pixels.
+      int height = 0;
+
+      /// The atlas texture.
+      GLuint texture = 0;
+  };
+}
+
+#endif // _GLYPH_ATLAS_H_
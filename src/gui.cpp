@@ -1,6 +1,11 @@
 #include "gui.hpp"
+#include <algorithm>
+
+SDL_Texture* loadTexture(SDL_Renderer* windowRenderer, const char* path, const Sokoban::AssetBundle* bundle) {
+  std::vector<Sokoban::MipLevel> levels;
+  if (bundle != NULL && bundle->getImage(path, levels))
+    return createTexture(windowRenderer, levels[0]);
 
-SDL_Texture* loadTexture(SDL_Renderer* windowRenderer, const char* path) {
   SDL_Texture* newTexture = NULL;
   SDL_Surface* loadedSurface = IMG_Load(path);
   if(loadedSurface == NULL) {
@@ -18,13 +23,37 @@ SDL_Texture* loadTexture(SDL_Renderer* windowRenderer, const char* path) {
   return newTexture;
 }
 
-void renderSplashScreen(const char* path, unsigned timeout, SDL_Renderer* windowRenderer, SDL_Color backgroundColor) {
-  SDL_Texture* splashTexture = loadTexture(windowRenderer, path);
+SDL_Texture* createTexture(SDL_Renderer* windowRenderer, const Sokoban::MipLevel& image) {
+  SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom((void*) image.pixels, image.width, image.height,
+                                                            32, 4 * image.width, SDL_PIXELFORMAT_RGBA32);
+  if (surface == NULL) {
+    std::cout << "Unable to create surface! SDL Error: " << SDL_GetError() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  SDL_Texture* newTexture = SDL_CreateTextureFromSurface(windowRenderer, surface);
+  if (newTexture == NULL) {
+    std::cout << "Unable to create texture! SDL Error: " << SDL_GetError() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  SDL_FreeSurface(surface);
+  return newTexture;
+}
+
+void renderSplashScreen(const char* path, unsigned timeout, SDL_Renderer* windowRenderer, SDL_Color backgroundColor,
+                        const Sokoban::AssetLoader& loader, const Sokoban::AssetBundle* bundle) {
+  SDL_Texture* splashTexture = loadTexture(windowRenderer, path, bundle);
   SDL_SetRenderDrawColor(windowRenderer, backgroundColor.r, backgroundColor.r, backgroundColor.b, backgroundColor.a);
   SDL_RenderClear(windowRenderer);
   SDL_RenderCopy(windowRenderer, splashTexture, NULL, NULL);
   SDL_RenderPresent(windowRenderer);
-  SDL_Delay(timeout);
+
+  /* Keep the window responsive while the assets are decoded in the background. */
+  Uint32 start = SDL_GetTicks();
+  while (SDL_GetTicks() - start < timeout || !loader.isDone()) {
+    SDL_PumpEvents();
+    SDL_Delay(10);
+  }
+  SDL_Log("Splash screen shown for %u ms", SDL_GetTicks() - start);
   SDL_DestroyTexture(splashTexture);
 }
 
@@ -40,7 +69,8 @@ void SDL_DIE(std::string msg) {
 }
 
 namespace Sokoban {
-  Gui::Gui() {
+  Gui::Gui(RendererType rendererType) :
+    rendererType(rendererType) {
     /* Initialize SDL. */
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
       SDL_DIE("SDL could not be initialized");
@@ -52,13 +82,19 @@ namespace Sokoban {
     }
 
     /* Create the main window. */
-    window = SDL_CreateWindow(GAME_TITLE, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN | SDL_WINDOW_OPENGL);// | SDL_WINDOW_FULLSCREEN_DESKTOP);
+    /* The 2D renderer needs no OpenGL at all. */
+    Uint32 windowFlags = rendererType == RENDERER_3D ? SDL_WINDOW_SHOWN | SDL_WINDOW_OPENGL : SDL_WINDOW_SHOWN;
+    window = SDL_CreateWindow(GAME_TITLE, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, windowFlags);// | SDL_WINDOW_FULLSCREEN_DESKTOP);
     if (window == NULL) {
       SDL_DIE("SDL Window could not be created");
     }
 
     /* Create the renderer for the window. */
     windowRenderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_TARGETTEXTURE);
+    if(windowRenderer == NULL) {
+      std::cout << "INFO: No accelerated renderer (" << SDL_GetError() << "), using the software one" << std::endl;
+      windowRenderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE);
+    }
     if(windowRenderer == NULL) {
       SDL_DIE("Renderer could not be created");
     }
@@ -84,39 +120,45 @@ namespace Sokoban {
     if(Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
       SDL_DIE("SDL_Mixer could not initialize");
     }
-    else {
-      soundBackgroundMusic = Mix_LoadMUS("assets/sound/expshooter2.mp3" );
-      if(soundBackgroundMusic == NULL) {
-        SDL_DIE("Failed to load background music");
-      }
-
-      soundCharacterMoved = Mix_LoadWAV("assets/sound/baseball_hit.wav");
-      if(soundCharacterMoved == NULL) {
-        SDL_DIE("Failed to load character movement sound");
-      }
-
-      soundBoxMoved = Mix_LoadWAV("assets/sound/blip.wav");
-      if(soundBoxMoved == NULL) {
-        SDL_DIE("Failed to load box movemend sound");
-      }
 
-      soundStageFinished = Mix_LoadWAV("assets/sound/stageFinished.wav");
-      if (soundStageFinished == NULL) {
-        SDL_DIE("Failed to load stage finished sound");
-      }
+    /* Map the prebuilt assets. */
+    if (!assetBundle.open(ASSET_BUNDLE_PATH)) {
+      std::cout << "INFO: No asset bundle at " << ASSET_BUNDLE_PATH << ", assets will be decoded" << std::endl;
+    }
 
-      soundSplash = Mix_LoadWAV("assets/sound/pacman.wav");
-      if (soundSplash == NULL) {
-        SDL_DIE("Failed to load splash sound");
-      }
+    /* Queue everything else missing from the bundle, to be decoded while the splash screen is shown. */
+    int frequency, channels; Uint16 format;
+    Mix_QuerySpec(&frequency, &format, &channels);
+    assetLoader = new AssetLoader();
+    if (assetBundle.find(MUSIC_BACKGROUND_PATH, BUNDLE_FILE) == NULL)
+      assetLoader->requestFile(MUSIC_BACKGROUND_PATH);
+    for (const char* path : {SOUND_CHARACTER_MOVED_PATH, SOUND_BOX_MOVED_PATH, SOUND_STAGE_FINISHED_PATH})
+      if (findSound(path) == NULL)
+        assetLoader->requestSound(path, frequency, format, channels);
+    if (assetBundle.find(MENU_BACKGROUND_TEXTURE_PATH, BUNDLE_IMAGE) == NULL)
+      assetLoader->requestImage(MENU_BACKGROUND_TEXTURE_PATH);
+    if (rendererType == RENDERER_2D)
+      SpriteRenderer::requestTextures(*assetLoader, &assetBundle);
+    else
+      SceneRenderer::requestTextures(*assetLoader, &assetBundle);
+
+    /* The splash sound is needed right away. */
+    soundSplash = Mix_LoadWAV("assets/sound/pacman.wav");
+    if (soundSplash == NULL) {
+      SDL_DIE("Failed to load splash sound");
     }
   }
 
   Gui::~Gui() {
-    /* Destroy OpenGL. */
-    SDL_GL_DeleteContext(glContext);
+    /* Stop the asset loader, if the game was never started. */
+    delete assetLoader;
+    assetLoader = NULL;
+
+    /* Destroy OpenGL (the game owns GL objects, so it goes first). */
     delete game;
     game = NULL;
+    if (OPENGL_LOADED)
+      SDL_GL_DeleteContext(glContext);
 
     /* Destroy textures. */
     SDL_DestroyTexture(backgroundTexture);
@@ -159,31 +201,126 @@ namespace Sokoban {
   }
 
   void Gui::loadOpenGL() {
-    /* Create the OpenGL context. */
-    glContext = SDL_GL_CreateContext(window);
+    /* Set OpenGL attributes. */
+    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+    SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
+    SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
+    SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
+    SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, 8);
+
+    /* Create the OpenGL context: 3.3 core for the shaders, else a legacy one for the fixed-function pipeline. */
+    glContext = NULL;
+    if (std::getenv("SOKOBAN_FIXED_FUNCTION") == NULL) {
+      SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+      SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+      SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+      glContext = SDL_GL_CreateContext(window);
+      if (glContext == NULL)
+        SDL_Log("No OpenGL 3.3 core context (%s), using the fixed-function pipeline", SDL_GetError());
+    }
+    renderPath = glContext != NULL ? RENDER_PATH_SHADERS : RENDER_PATH_FIXED;
+    if (glContext == NULL) {
+      SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
+      SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
+      SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, 0);
+      glContext = SDL_GL_CreateContext(window);
+    }
     if(glContext == NULL) {
       SDL_DIE("OpenGL context could not be created");
     }
 
+    /* Load the OpenGL entry points (vertex buffers and up). */
+    glewExperimental = GL_TRUE;
+    GLenum glewError = glewInit();
+    if (glewError != GLEW_OK) {
+      SDL_DIE(std::string("GLEW could not be initialized: ") + (const char*) glewGetErrorString(glewError));
+    }
+    /* GLEW probes core contexts with legacy queries: drop the error they leave. */
+    glGetError();
+    SDL_Log("OpenGL %s on %s (%s pipeline)", glGetString(GL_VERSION), glGetString(GL_RENDERER),
+            renderPath == RENDER_PATH_SHADERS ? "shader" : "fixed-function");
+
     OPENGL_LOADED = true;
   }
 
+  void Gui::createGame() {
+    Renderer* renderer = NULL;
+    if (rendererType == RENDERER_2D) {
+      SDL_Log("2D renderer");
+      renderer = new SpriteRenderer(windowRenderer, SCREEN_WIDTH, SCREEN_HEIGHT, windowFont, assetLoader, &assetBundle);
+    }
+    else {
+      loadOpenGL();
+      renderer = new SceneRenderer(window, SCREEN_WIDTH, SCREEN_HEIGHT, windowFont, windowRenderer, assetLoader, &assetBundle, renderPath);
+    }
+    game = new Game(renderer);
+    game->setProfilerOverlay(profilerOverlay);
+    game->setAnimation(animationDuration, animationEasing);
+    game->setInput(InputQueue::REPEAT_DELAY, keyRepeatInterval, coalesceMoves);
+
+    /* Wake the main loop up whenever the simulation publishes a board to draw. */
+    Uint32 snapshotEvent = SDL_RegisterEvents(1);
+    if (snapshotEvent != (Uint32) -1) {
+      game->setSnapshotListener([snapshotEvent] {
+        SDL_Event event = SDL_Event();
+        event.type = snapshotEvent;
+        SDL_PushEvent(&event);
+      });
+    }
+
+    /* Everything has been taken from the loader by now. */
+    delete assetLoader;
+    assetLoader = NULL;
+  }
+
   void Gui::gameLoop() {
     bool quit = false;
     SDL_Event e;
 
-    /* Show the game splash screen. */
+    /* Show the game splash screen while the assets load. */
     Mix_PlayChannel(-1, soundSplash, 0);
-    renderSplashScreen(SPLASH_TEXTURE_PATH, GAME_SPLASH_TIMEOUT, windowRenderer, WINDOW_CLEAR_COLOR);
+    renderSplashScreen(SPLASH_TEXTURE_PATH, GAME_SPLASH_TIMEOUT, windowRenderer, WINDOW_CLEAR_COLOR, *assetLoader, &assetBundle);
+
+    /* Create the sounds from the bundle or the decoded samples. The music is streamed from memory. */
+    const BundleEntry* musicEntry = assetBundle.find(MUSIC_BACKGROUND_PATH, BUNDLE_FILE);
+    if (musicEntry != NULL)
+      soundBackgroundMusic = Mix_LoadMUS_RW(SDL_RWFromConstMem(assetBundle.getData(*musicEntry), musicEntry->size), 1);
+    else if (assetLoader->takeFile(MUSIC_BACKGROUND_PATH, musicData))
+      soundBackgroundMusic = Mix_LoadMUS_RW(SDL_RWFromConstMem(musicData.data(), musicData.size()), 1);
+    if (soundBackgroundMusic == NULL) {
+      SDL_DIE("Failed to load background music");
+    }
+    soundCharacterMoved = takeSound(SOUND_CHARACTER_MOVED_PATH);
+    soundBoxMoved = takeSound(SOUND_BOX_MOVED_PATH);
+    soundStageFinished = takeSound(SOUND_STAGE_FINISHED_PATH);
 
     /* Show the main menu. */
-    backgroundTexture = loadTexture(windowRenderer, MENU_BACKGROUND_TEXTURE_PATH);
+    Image backgroundImage;
+    if (assetLoader->takeImage(MENU_BACKGROUND_TEXTURE_PATH, backgroundImage)) {
+      MipLevel level;
+      level.width = backgroundImage.width;
+      level.height = backgroundImage.height;
+      level.pixels = backgroundImage.pixels.data();
+      backgroundTexture = createTexture(windowRenderer, level);
+    }
+    else
+      backgroundTexture = loadTexture(windowRenderer, MENU_BACKGROUND_TEXTURE_PATH, &assetBundle);
     gameMenu = new Menu(windowRenderer, MENU_LABEL_IN_COLOR, MENU_LABEL_OUT_COLOR, windowFont, SCREEN_WIDTH, SCREEN_HEIGHT, GAME_MENU_LABELS, backgroundTexture);
 
     /* Play the background music. */
     Mix_PlayMusic(soundBackgroundMusic, -1);
 
     while(!quit) {
+      // Sleep until something happens when there is nothing new to draw.
+      // The event stays queued for the loop below.
+      if (!needsRedraw())
+        SDL_WaitEventTimeout(NULL, eventTimeout());
+
+      // A frame is timed from here, once awake, to its buffer swap.
+      Profiler& profiler = Profiler::instance();
+      uint64_t frameStart = profiler.now();
+
       while(SDL_PollEvent(&e) != 0) {
         // Quit event.
         if (e.type == SDL_QUIT) {
@@ -192,7 +329,8 @@ namespace Sokoban {
         }
 
         // Window resize event.
-        else if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_RESIZED && context == CONTEXT_GAME) {
+        else if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_RESIZED &&
+                 (context == CONTEXT_GAME || context == CONTEXT_STAGE_FINISHED)) {
           unsigned width = e.window.data1;
           unsigned height = e.window.data2;
           SDL_Log("SDL_WINDOWEVENT: SDL_WINDOWEVENT_RESIZED: %d x %d", width, height);
@@ -200,6 +338,37 @@ namespace Sokoban {
           game->setWindowSize(width, height);
         }
 
+        // Window exposed event: the previous frame is lost.
+        else if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_EXPOSED) {
+          if (context == CONTEXT_MAIN_MENU)
+            gameMenu->invalidate();
+          else if (context == CONTEXT_GAME || context == CONTEXT_STAGE_FINISHED)
+            game->invalidate();
+        }
+
+        // Key repeats are left to the simulation while playing: it repeats a held move at its own rate.
+        else if (e.type == SDL_KEYDOWN && e.key.repeat && context == CONTEXT_GAME) {
+          continue;
+        }
+
+        // Key release event: a held move stops repeating.
+        else if (e.type == SDL_KEYUP && context == CONTEXT_GAME) {
+          switch(e.key.keysym.sym) {
+            case SDLK_s:
+            case SDLK_DOWN:
+              game->releaseMoveAction(Direction::DOWN); break;
+            case SDLK_w:
+            case SDLK_UP:
+              game->releaseMoveAction(Direction::UP); break;
+            case SDLK_a:
+            case SDLK_LEFT:
+              game->releaseMoveAction(Direction::LEFT); break;
+            case SDLK_d:
+            case SDLK_RIGHT:
+              game->releaseMoveAction(Direction::RIGHT); break;
+          }
+        }
+
         // Key press event.
         else if (e.type == SDL_KEYDOWN) {
           SDL_Log("SDL_KEYDOWN event: %s", SDL_GetKeyName(e.key.keysym.sym));
@@ -216,12 +385,7 @@ namespace Sokoban {
                 gameMenu->nextIndex();
               }
               else if (context == CONTEXT_GAME){
-                bool boxMoved = game->moveDownAction();
-                if (boxMoved)
-                  boxMovedEvent();
-                else 
-                  characterMovedEvent();
-                SDL_Log(game->getGameBoard()->toString().c_str());
+                game->moveDownAction();
               }
               break;
               // Up key:
@@ -231,36 +395,21 @@ namespace Sokoban {
                 gameMenu->prevIndex();
               }
               else if (context == CONTEXT_GAME){
-                bool boxMoved = game->moveUpAction();
-                if (boxMoved)
-                  boxMovedEvent();
-                else 
-                  characterMovedEvent();
-                SDL_Log(game->getGameBoard()->toString().c_str());
+                game->moveUpAction();
               }
               break;
               // Left key.
             case SDLK_a:
             case SDLK_LEFT:
               if (context == CONTEXT_GAME){
-                bool boxMoved = game->moveLeftAction();
-                if (boxMoved)
-                  boxMovedEvent();
-                else 
-                  characterMovedEvent();
-                SDL_Log(game->getGameBoard()->toString().c_str());
+                game->moveLeftAction();
               }
               break;
               // Right key.
             case SDLK_d:
             case SDLK_RIGHT:
               if (context == CONTEXT_GAME){
-                bool boxMoved = game->moveRightAction();
-                if (boxMoved)
-                  boxMovedEvent();
-                else 
-                  characterMovedEvent();
-                SDL_Log(game->getGameBoard()->toString().c_str());
+                game->moveRightAction();
               }
               break;
               // Mute key
@@ -274,6 +423,12 @@ namespace Sokoban {
                 SDL_Log("Background music paused");
               }
               break;
+              // Profiler overlay key
+            case SDLK_F3:
+              profilerOverlay = !profilerOverlay;
+              if (context == CONTEXT_GAME)
+                game->setProfilerOverlay(profilerOverlay);
+              break;
               // Restart key
             case SDLK_r:
               if (context == CONTEXT_GAME) {
@@ -283,13 +438,8 @@ namespace Sokoban {
               break;
             case SDLK_u:
               if (context == CONTEXT_GAME) {
-                bool boxMoved = game->undoAction();
-                if (boxMoved)
-                  boxMovedEvent();
-                else
-                  characterMovedEvent();
+                game->undoAction();
                 SDL_Log("Undo action");
-                SDL_Log(game->getGameBoard()->toString().c_str());
               }
               break;
             case SDLK_RETURN:
@@ -300,11 +450,10 @@ namespace Sokoban {
                 }
                 else {
                   context = CONTEXT_GAME;
-                  if(!OPENGL_LOADED) {
-                    loadOpenGL();
-                    game = new Game(window, &glContext, SCREEN_WIDTH, SCREEN_HEIGHT, windowFont, windowRenderer);
+                  if(game == NULL) {
+                    createGame();
                   }
-                  game->loadLevel(index + 1);
+                  startLevel(index + 1);
                 }
               }
               break;
@@ -325,6 +474,12 @@ namespace Sokoban {
               SDL_Log("Mouse Button 1 (left) is being pressed and moved: %d, %d", x, y);
               game->setNewPosition(x, y);
             }
+            else if (mouseState & SDL_BUTTON(SDL_BUTTON_RIGHT)) {
+              game->setNewPosition(x, y, true);
+            }
+          }
+          else if (context == CONTEXT_MAIN_MENU) {
+            gameMenu->invalidate();
           }
         }
         /// Mouse click event.
@@ -339,53 +494,136 @@ namespace Sokoban {
               }
               else {
                 context = CONTEXT_GAME;
-                if(!OPENGL_LOADED) {
-                  loadOpenGL();
-                  game = new Game(window, &glContext, SCREEN_WIDTH, SCREEN_HEIGHT, windowFont, windowRenderer);
+                if(game == NULL) {
+                  createGame();
                 }
-                game->loadLevel(index + 1);
+                startLevel(index + 1);
               }
             }
             else if(context == CONTEXT_GAME) {
               game->setOldPosition(x, y);
             }
           }
+          else if ((mouseState & SDL_BUTTON(SDL_BUTTON_RIGHT)) && context == CONTEXT_GAME) {
+            game->setOldPosition(x, y);
+          }
+        }
+      }
+      profiler.record("Gui::pollEvents", frameStart, profiler.now() - frameStart);
+      if (quit || updateTransition())
+        break;
+
+      // Sounds for what the board did with the keys pressed so far: one per step of the character.
+      if (context == CONTEXT_GAME) {
+        game->takeEvents(simulationEvents);
+        bool pushed = false;
+        for (const SokoEvent& event : simulationEvents) {
+          if (event.type == SokoEvent::SOKO_BOX_MOVED)
+            pushed = true;
+          else if (event.type == SokoEvent::SOKO_PLAYER_MOVED) {
+            if (pushed)
+              boxMovedEvent();
+            else
+              characterMovedEvent();
+            pushed = false;
+          }
         }
       }
 
-      // Actual rendering happens here.
-      if (context == CONTEXT_MAIN_MENU) {
+      // Actual rendering happens here, only for frames that changed.
+      if (!needsRedraw()) {
+        continue;
+      }
+      else if (context == CONTEXT_MAIN_MENU) {
         gameMenu->renderMainMenu();
       }
-      else if (context == CONTEXT_GAME) {
+      else if (context == CONTEXT_GAME || context == CONTEXT_STAGE_FINISHED) {
         game->renderScene();
-        checkLoadNextLevel(e);
+        profiler.record("Frame", frameStart, profiler.now() - frameStart);
+        checkLoadNextLevel();
       }
       else if (context == CONTEXT_GAME_FINISHED) {
         SDL_Log("Congratulations, you've won the game!");
         game->renderSingleImage(GAME_FINISHED_IMAGE_PATH);
-        Mix_HaltMusic(); 
-        SDL_Delay(GAME_FINISHED_TIMEOUT);
-        quit = true; break;
+        Mix_HaltMusic();
+        gameFinishedShown = true;
       }
       // Actual rendering ends here.
     }
+
+    if (!tracePath.empty())
+      Profiler::instance().writeTrace(tracePath);
   }
 
-  void Gui::checkLoadNextLevel(const SDL_Event& e) {
-    if (context == CONTEXT_GAME && isMovementKey(e.key.keysym.sym) && game->isLevelFinished()) {
-      if (game->getCurrentLevel() == (GAME_MENU_LABELS.size() - 1)) {
-        SDL_Log("Finished the last level (%d). Switching to CONTEXT_GAME_FINISHED.", 
-                game->getCurrentLevel());
-        context = CONTEXT_GAME_FINISHED;
-      }
-      else {
-        SDL_Log("Finished level %d", game->getCurrentLevel());
-        game->loadLevel(game->getCurrentLevel() + 1);
-      }
+  void Gui::setTracePath(const std::string& path) {
+    tracePath = path;
+  }
+
+  void Gui::setProfilerOverlay(bool visible) {
+    profilerOverlay = visible;
+  }
+
+  void Gui::setAnimation(double duration, Easing easing) {
+    animationDuration = duration;
+    animationEasing = easing;
+  }
+
+  void Gui::setKeyRepeat(double interval, bool coalesce) {
+    keyRepeatInterval = interval;
+    coalesceMoves = coalesce;
+  }
+
+  bool Gui::needsRedraw() const {
+    if (context == CONTEXT_MAIN_MENU)
+      return gameMenu->isDirty();
+    else if (context == CONTEXT_GAME || context == CONTEXT_STAGE_FINISHED)
+      return game->needsRedraw();
+    return !gameFinishedShown;
+  }
+
+  void Gui::checkLoadNextLevel() {
+    if (context == CONTEXT_GAME && game->isLevelFinished()) {
+      SDL_Log("Finished level %d", game->getCurrentLevel());
       Mix_PlayChannel(-1, soundStageFinished, 0);
-      SDL_Delay(STAGE_FINISHED_TIMEOUT);
+      context = CONTEXT_STAGE_FINISHED;
+      transitionEnd = SDL_GetTicks() + STAGE_FINISHED_TIMEOUT;
+    }
+  }
+
+  bool Gui::updateTransition() {
+    if ((context != CONTEXT_STAGE_FINISHED && context != CONTEXT_GAME_FINISHED) ||
+        !SDL_TICKS_PASSED(SDL_GetTicks(), transitionEnd))
+      return false;
+    if (context == CONTEXT_GAME_FINISHED)
+      return true;
+
+    if (game->getCurrentLevel() == (GAME_MENU_LABELS.size() - 1)) {
+      SDL_Log("Finished the last level (%d). Switching to CONTEXT_GAME_FINISHED.",
+              game->getCurrentLevel());
+      context = CONTEXT_GAME_FINISHED;
+      transitionEnd = SDL_GetTicks() + GAME_FINISHED_TIMEOUT;
+    }
+    else {
+      // Preloaded during the stage that just ended: nothing is parsed or built here.
+      context = CONTEXT_GAME;
+      startLevel(game->getCurrentLevel() + 1);
     }
+    return false;
+  }
+
+  Uint32 Gui::eventTimeout() const {
+    if (context != CONTEXT_STAGE_FINISHED && context != CONTEXT_GAME_FINISHED)
+      return IDLE_EVENT_TIMEOUT;
+    Uint32 now = SDL_GetTicks();
+    if (SDL_TICKS_PASSED(now, transitionEnd))
+      return 0;
+    return std::min(Uint32(IDLE_EVENT_TIMEOUT), transitionEnd - now);
+  }
+
+  void Gui::startLevel(unsigned level) {
+    game->loadLevel(level);
+    if (level < GAME_MENU_LABELS.size() - 1)
+      game->preloadLevel(level + 1);
   }
 
   void Gui::boxMovedEvent() const {
@@ -395,4 +633,33 @@ namespace Sokoban {
   void Gui::characterMovedEvent() const {
     Mix_PlayChannel(-1, soundCharacterMoved, 0);
   }
+
+  const BundleEntry* Gui::findSound(const char* path) const {
+    int frequency, channels; Uint16 format;
+    Mix_QuerySpec(&frequency, &format, &channels);
+    const BundleEntry* entry = assetBundle.find(path, BUNDLE_SOUND);
+    if (entry == NULL || entry->info[0] != Uint32(frequency) || entry->info[1] != format || entry->info[2] != Uint32(channels))
+      return NULL;
+    return entry;
+  }
+
+  Mix_Chunk* Gui::takeSound(const char* path) {
+    Mix_Chunk* chunk = NULL;
+    const BundleEntry* entry = findSound(path);
+    if (entry != NULL) {
+      /* SDL_mixer only reads the samples, straight from the mapping. */
+      chunk = Mix_QuickLoad_RAW((Uint8*) assetBundle.getData(*entry), entry->size);
+    }
+    else {
+      Sound& sound = soundSamples[path];
+      if (!assetLoader->takeSound(path, sound)) {
+        SDL_DIE(std::string("Failed to load sound ") + path);
+      }
+      chunk = Mix_QuickLoad_RAW(sound.samples.data(), sound.samples.size());
+    }
+    if (chunk == NULL) {
+      SDL_DIE(std::string("Failed to create sound ") + path);
+    }
+    return chunk;
+  }
 }
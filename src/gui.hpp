@@ -3,19 +3,27 @@
 
 #include <cstdlib>
 #include <iostream>
+#include <map>
 #include <string>
+#include "asset_loader.hpp"
 #include "game.hpp"
+#include "scene_renderer.hpp"
 #include "sdl_menu.hpp"
+#include "sprite_renderer.hpp"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_mixer.h>
 #include <SDL2/SDL_ttf.h>
 
-/// Load a SDL Texture with the given renderer at the given path.
-SDL_Texture* loadTexture(SDL_Renderer*, const char* path);
+/// Load a SDL Texture with the given renderer at the given path, from @bundle if it is there.
+SDL_Texture* loadTexture(SDL_Renderer*, const char* path, const Sokoban::AssetBundle* bundle = NULL);
 
-/// Render a splash screen with the given timeout..
-void renderSplashScreen(const char* path, unsigned timeout, SDL_Renderer*, SDL_Color);
+/// Create a SDL Texture with the given renderer from decoded RGBA pixels.
+SDL_Texture* createTexture(SDL_Renderer*, const Sokoban::MipLevel& image);
+
+/// Render a splash screen until @loader is done, for at least @timeout milliseconds.
+void renderSplashScreen(const char* path, unsigned timeout, SDL_Renderer*, SDL_Color,
+                        const Sokoban::AssetLoader& loader, const Sokoban::AssetBundle* bundle = NULL);
 
 /// Return true if @key is a movement key.
 bool isMovementKey(const SDL_Keycode& key);
@@ -32,12 +40,13 @@ namespace Sokoban {
     typedef enum Context {
       CONTEXT_MAIN_MENU = 0,
       CONTEXT_GAME = 1,
-      CONTEXT_GAME_FINISHED = 2
+      CONTEXT_GAME_FINISHED = 2,
+      CONTEXT_STAGE_FINISHED = 3
     } Context;
 
     public:
-    /// SDL initialization.
-    Gui();
+    /// SDL initialization, for a game drawn by the @rendererType renderer.
+    explicit Gui(RendererType rendererType = RENDERER_3D);
 
     /// Clean up SDL artifacts.
     ~Gui();
@@ -45,12 +54,37 @@ namespace Sokoban {
     /// Main game loop. Continuously monitors for user input and renderizes the game on the scree.
     void gameLoop();
 
+    /// Write the profiled scopes to @path (Chrome trace_event JSON) when the game loop ends.
+    void setTracePath(const std::string& path);
+
+    /// Show the frame time percentiles over the game (also toggled with F3).
+    void setProfilerOverlay(bool visible);
+
+    /// Animate the moves over @duration seconds (none if not positive) with @easing.
+    void setAnimation(double duration, Easing easing);
+
+    /// Repeat a held move key every @interval seconds; with @coalesce, long walks are animated faster.
+    void setKeyRepeat(double interval, bool coalesce);
+
     private:
     /// Load OpenGL for the first time.
     void loadOpenGL();
 
-    /// Check if the current level is finished. If yes, load the next level or end the game, if it is the last level.
-    void checkLoadNextLevel(const SDL_Event&);
+    /// Return true if the current context has a frame to draw.
+    bool needsRedraw() const;
+
+    /// Check if the current level is finished. If yes, start the transition to the next level (or to the end of the game).
+    void checkLoadNextLevel();
+
+    /// End the transition started by checkLoadNextLevel() once its time is over: load the next level, or end the game.
+    /// Returns true when the game is over.
+    bool updateTransition();
+
+    /// Longest wait for an event (in milliseconds): the idle timeout, or less if a transition ends before.
+    Uint32 eventTimeout() const;
+
+    /// Load @level and preload the one after it, if any.
+    void startLevel(unsigned level);
 
     /// Whenever a box is moved, this event should be called.
     void boxMovedEvent() const;
@@ -58,6 +92,15 @@ namespace Sokoban {
     /// Whenever a character is moved, this event should be called.
     void characterMovedEvent() const;
 
+    /// Return the bundle entry with the samples of @path in the mixer format, or NULL.
+    const BundleEntry* findSound(const char* path) const;
+
+    /// Create the sound chunk for @path from the bundle or the samples decoded by the asset loader.
+    Mix_Chunk* takeSound(const char* path);
+
+    /// Create the game and its renderer, taking the textures already decoded by the asset loader.
+    void createGame();
+
     /// The main SDL window.
     SDL_Window *window = NULL;
 
@@ -76,15 +119,56 @@ namespace Sokoban {
     /// The game renderization engine.
     Game *game = NULL;
 
+    /// Where to write the trace of the profiled scopes (empty: nowhere).
+    std::string tracePath;
+
+    /// Whether the frame time percentiles are shown.
+    bool profilerOverlay = false;
+
+    /// Animation of the moves, as set on the command line.
+    double animationDuration = Simulation::ANIMATION_DURATION;
+    Easing animationEasing = EASING_LINEAR;
+
+    /// Time between two moves of a held key (in seconds), and whether walks are coalesced.
+    double keyRepeatInterval = InputQueue::REPEAT_INTERVAL;
+    bool coalesceMoves = false;
+
+    /// Events taken from the game simulation, reused every loop.
+    std::vector<SokoEvent> simulationEvents;
+
     /// OpenGL context for SDL.
-    SDL_GLContext glContext;
+    SDL_GLContext glContext = NULL;
 
     /// The current context the user is on.
     Context context = CONTEXT_MAIN_MENU;
 
+    /// When the current transition (CONTEXT_STAGE_FINISHED or CONTEXT_GAME_FINISHED) ends, in SDL ticks.
+    Uint32 transitionEnd = 0;
+
+    /// Whether the end game image was shown.
+    bool gameFinishedShown = false;
+
     /// Indicate if OpenGL has already been initialized.
     bool OPENGL_LOADED = false;
 
+    /// Renderer the game is drawn with: 3D (OpenGL) or 2D (the SDL renderer).
+    RendererType rendererType;
+
+    /// Pipeline the game renders with, picked from the context loadOpenGL() got.
+    RenderPath renderPath = RENDER_PATH_FIXED;
+
+    /// Prebuilt assets, used in place of the original files when present.
+    AssetBundle assetBundle;
+
+    /// Decodes the assets in the background while the splash screen is shown. Released once the game is created.
+    AssetLoader *assetLoader = NULL;
+
+    /// Decoded samples of the sound chunks, by path. The chunks point into them.
+    std::map<std::string, Sound> soundSamples;
+
+    /// Raw bytes of the background music file, streamed by SDL_mixer.
+    std::vector<unsigned char> musicData;
+
     // Game settings.
     
     /// Game background music.
@@ -108,15 +192,18 @@ namespace Sokoban {
     /// The screen height.
     const int SCREEN_HEIGHT = 600;
 
-    // Duration of the game splash screen (in milliseconds).
-    const int GAME_SPLASH_TIMEOUT = 4300;
+    // Minimum duration of the game splash screen (in milliseconds). It lasts until the assets are loaded.
+    const int GAME_SPLASH_TIMEOUT = 1500;
 
     /// Duration of the end game screen (in milliseconds).
     const int GAME_FINISHED_TIMEOUT = 3000;
 
-    /// Delay between two stages.
+    /// Delay between two stages (in milliseconds). The finished stage stays on screen meanwhile.
     const int STAGE_FINISHED_TIMEOUT = 1500;
 
+    /// Longest wait for an event when nothing has to be drawn (in milliseconds).
+    const int IDLE_EVENT_TIMEOUT = 250;
+
     const vector<const char*> GAME_MENU_LABELS = vector<const char*>{"Stage 1", "Stage 2", "Stage 3", "Quit"}; // Quit must be the last option.
 
     /// Name of the game.
@@ -131,6 +218,21 @@ namespace Sokoban {
     /// Path to the image to be loaded when the game finishes. 
     const char* GAME_FINISHED_IMAGE_PATH="assets/textures/game_finished.png";
 
+    /// Path to the asset bundle written by the bundler.
+    const char* ASSET_BUNDLE_PATH = "assets/assets.bundle";
+
+    /// Path to the background music.
+    const char* MUSIC_BACKGROUND_PATH = "assets/sound/expshooter2.mp3";
+
+    /// Path to the character movement sound.
+    const char* SOUND_CHARACTER_MOVED_PATH = "assets/sound/baseball_hit.wav";
+
+    /// Path to the box movement sound.
+    const char* SOUND_BOX_MOVED_PATH = "assets/sound/blip.wav";
+
+    /// Path to the stage finished sound.
+    const char* SOUND_STAGE_FINISHED_PATH = "assets/sound/stageFinished.wav";
+
     /// Path to the game font.
     const char* GAME_FONT_PATH = "assets/Roboto-Regular.ttf";
 
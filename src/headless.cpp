@@ -0,0 +1,107 @@
+#include "headless.hpp"
+#include "asset_bundle.hpp"
+#include "game.hpp"
+#include "offscreen.hpp"
+#include "profiler.hpp"
+#include "scene_renderer.hpp"
+#include <dirent.h>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+namespace Sokoban {
+
+namespace {
+  /// Path of the PNG for the level in @levelPath: its file name, with a .png extension, in @directory.
+  std::string imagePath(const std::string& directory, const std::string& levelPath) {
+    std::string name = levelPath.substr(levelPath.find_last_of('/') + 1);
+    name = name.substr(0, name.find_last_of('.')) + ".png";
+    return directory + "/" + name;
+  }
+
+  /// Render the levels of @levels claimed through @next until there are none left, counting them in @attempted.
+  void renderWorker(const std::vector<std::string>& levels, const HeadlessOptions& options,
+                    const AssetBundle* bundle, std::atomic<unsigned>& next, std::atomic<unsigned>& attempted,
+                    std::atomic<unsigned>& failures) {
+    OffscreenContext context;
+    if (!context.create(options.width, options.height, options.fixedFunction)) {
+      // Another worker may still get a context: leave the levels to it.
+      return;
+    }
+
+    Game game(new SceneRenderer(NULL, options.width, options.height, NULL, NULL, NULL, bundle, context.getRenderPath()));
+    Profiler& profiler = Profiler::instance();
+    Image image;
+    for (unsigned i = next.fetch_add(1); i < levels.size(); i = next.fetch_add(1)) {
+      attempted++;
+      game.loadLevel(i + 1, levels[i]);
+      game.waitForSimulation();
+      for (unsigned frame = 0; frame < std::max(options.frames, 1u); frame++) {
+        uint64_t start = profiler.now();
+        game.invalidate();
+        game.renderScene();
+        glFinish();
+        profiler.record("Headless::frame", start, profiler.now() - start);
+      }
+
+      const BoardSnapshot& snapshot = game.getSnapshot();
+      if (!snapshot.layout || snapshot.layout->getNumberOfRows() == 0) {
+        std::cout << "INFO: Unable to render " << levels[i] << std::endl;
+        failures++;
+        continue;
+      }
+      if (!options.outputDirectory.empty()) {
+        context.readPixels(image);
+        if (!savePng(imagePath(options.outputDirectory, levels[i]), image))
+          failures++;
+      }
+    }
+  }
+}
+
+std::vector<std::string> findLevels(const std::string& path) {
+  std::vector<std::string> levels;
+  DIR* directory = opendir(path.c_str());
+  if (directory == NULL) {
+    levels.push_back(path);
+    return levels;
+  }
+  while (dirent* entry = readdir(directory)) {
+    std::string name = entry->d_name;
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".sok") == 0)
+      levels.push_back(path + "/" + name);
+  }
+  closedir(directory);
+  std::sort(levels.begin(), levels.end());
+  return levels;
+}
+
+unsigned renderLevels(const std::vector<std::string>& levels, const HeadlessOptions& options) {
+  AssetBundle bundle;
+  bool bundled = bundle.open(options.bundlePath);
+  unsigned threads = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min<unsigned>(threads, std::max<size_t>(levels.size(), 1));
+
+  Profiler& profiler = Profiler::instance();
+  uint64_t start = profiler.now();
+  std::atomic<unsigned> next(0), attempted(0), failures(0);
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < threads; i++)
+    workers.push_back(std::thread(renderWorker, std::cref(levels), std::cref(options),
+                                  bundled ? &bundle : NULL, std::ref(next), std::ref(attempted), std::ref(failures)));
+  for (std::thread& worker : workers)
+    worker.join();
+
+  // Levels no worker got to, when no context could be created at all.
+  failures += levels.size() - attempted;
+
+  ProfileStatistics frames = profiler.statistics("Headless::frame", Profiler::CAPACITY);
+  std::cout << "INFO: Rendered " << levels.size() - failures << "/" << levels.size() << " levels with "
+            << threads << " workers in " << (profiler.now() - start) / 1e6 << " s; frame p50: "
+            << frames.p50 << " ms, p95: " << frames.p95 << " ms, p99: " << frames.p99 << " ms ("
+            << frames.count << " frames)" << std::endl;
+  return failures;
+}
+
+}
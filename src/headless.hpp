@@ -0,0 +1,42 @@
+#ifndef _HEADLESS_H_
+#define _HEADLESS_H_
+
+#include <string>
+#include <vector>
+
+namespace Sokoban {
+  /// Settings of an offscreen batch render.
+  struct HeadlessOptions {
+    /// Size of the rendered images, in pixels.
+    int width = 800;
+    int height = 600;
+
+    /// Number of workers, each with its own context (0: one per hardware thread).
+    unsigned threads = 0;
+
+    /// Frames rendered (and timed) per level; the last one is saved.
+    unsigned frames = 1;
+
+    /// Directory the PNGs are written to, one per level named after it (empty: none written).
+    std::string outputDirectory;
+
+    /// Render with the fixed-function pipeline instead of the shaders.
+    bool fixedFunction = false;
+
+    /// Prebuilt assets, used when present.
+    std::string bundlePath = "assets/assets.bundle";
+  };
+
+  /// Return the .sok files in the directory @path, sorted, or @path itself if it is not a directory.
+  std::vector<std::string> findLevels(const std::string& path);
+
+  /**
+  Render every level in @levels with no window, through the same Game as on
+  screen, and write each last frame to a PNG. Levels are shared between the
+  workers as they go. Frame times are logged once all are done.
+  Returns the number of levels that could not be rendered.
+  */
+  unsigned renderLevels(const std::vector<std::string>& levels, const HeadlessOptions& options);
+}
+
+#endif // _HEADLESS_H_
@@ -0,0 +1,68 @@
+#include "input_queue.hpp"
+
+namespace Sokoban {
+
+const double InputQueue::REPEAT_DELAY = 0.25;
+const double InputQueue::REPEAT_INTERVAL = 0.1;
+
+void InputQueue::setRepeat(double delay, double interval) {
+  repeatDelay = delay;
+  repeatInterval = interval;
+}
+
+void InputQueue::push(Direction direction) {
+  Input input = {false, direction};
+  inputs.push_back(input);
+}
+
+void InputQueue::press(Direction direction, double now) {
+  push(direction);
+  holding = true;
+  repeating = false;
+  held = direction;
+  repeatAt = now + repeatDelay;
+}
+
+void InputQueue::release(Direction direction) {
+  if (holding && held == direction)
+    holding = repeating = false;
+}
+
+void InputQueue::undo() {
+  Input input = {true, UP};
+  inputs.push_back(input);
+}
+
+void InputQueue::clear() {
+  inputs.clear();
+  holding = repeating = false;
+}
+
+bool InputQueue::next(double now, Input& input) {
+  if (!inputs.empty()) {
+    input = inputs.front();
+    inputs.pop_front();
+    return true;
+  }
+  if (!holding || now < repeatAt)
+    return false;
+  input.undo = false;
+  input.direction = held;
+  repeating = true;
+  repeatAt = now + repeatInterval;
+  return true;
+}
+
+unsigned InputQueue::pending() const {
+  return inputs.size() + (repeating ? 1 : 0);
+}
+
+bool InputQueue::isHolding() const {
+  return holding;
+}
+
+double InputQueue::nextRepeat() const {
+  return repeatAt;
+}
+
+}
@@ -0,0 +1,74 @@
+#ifndef _INPUT_QUEUE_H_
+#define _INPUT_QUEUE_H_
+
+#include <deque>
+#include "soko_position.hpp"
+
+namespace Sokoban {
+  /// What the player asked the board for: a move to @direction, or an undo.
+  struct Input {
+    bool undo;
+    Direction direction;
+  };
+
+  /**
+  The moves and undos the player asked for and the board did not take yet,
+  in order, plus the key held down, if any.
+
+  The board takes the next input only once it is ready for it (eg. when the
+  previous move is done animating), so nothing pressed is ever dropped. A held
+  key is repeated by the queue itself, and only when the board asks for the
+  next input: repeats never pile up behind a slow animation, and the character
+  stops as soon as the key is released. Times are in seconds, from any origin.
+  */
+  class InputQueue {
+    public:
+      /// Repeat a held key @delay after it was pressed, then every @interval.
+      void setRepeat(double delay, double interval);
+
+      /// Queue a single move to @direction.
+      void push(Direction direction);
+
+      /// Queue a move to @direction, pressed at @now, and repeat it while it is held.
+      void press(Direction direction, double now);
+
+      /// Stop repeating @direction, if it is the key held.
+      void release(Direction direction);
+
+      /// Queue an undo.
+      void undo();
+
+      /// Drop every queued input and forget the key held.
+      void clear();
+
+      /// Take the next input at @now: a queued one, else the held key if it is due. Returns false if there is none.
+      bool next(double now, Input& input);
+
+      /// Return the number of inputs waiting, counting a key already repeating as one.
+      unsigned pending() const;
+
+      /// Return true if a key is held.
+      bool isHolding() const;
+
+      /// Return the time the held key is due again (only meaningful while isHolding()).
+      double nextRepeat() const;
+
+      /// Time before a held key repeats, and between two repeats, until setRepeat() (in seconds).
+      static const double REPEAT_DELAY;
+      static const double REPEAT_INTERVAL;
+
+    private:
+      std::deque<Input> inputs;
+
+      /// The key held, when it repeats next and whether it already did.
+      bool holding = false;
+      bool repeating = false;
+      Direction held = UP;
+      double repeatAt = 0.0;
+
+      double repeatDelay = REPEAT_DELAY;
+      double repeatInterval = REPEAT_INTERVAL;
+  };
+}
+
+#endif // _INPUT_QUEUE_H_
@@ -0,0 +1,378 @@
+#include "level_mesh.hpp"
+#include <algorithm>
+#include <cstddef>
+
+namespace Sokoban {
+
+namespace {
+  /// Edge of a board cell (and of the cubes standing on it).
+  const GLfloat CELL_EDGE = 0.5;
+
+  /// Layers of the level: the floor slab and the walls on top of it.
+  const int LAYERS = 2;
+
+  /**
+  The six face directions: bottom, top, +x, -x, +y, -y. For each one:
+  the normal axis and sign, the two in-plane axes (a, b) used for texture
+  coordinates, and the corners of the quad as (a, b) min/max flags, in the
+  original winding order.
+  */
+  struct FaceDirection {
+    int axis, sign, a, b;
+    int corners[4][2];
+  };
+
+  const FaceDirection FACE_DIRECTIONS[6] = {
+    {2, -1, 0, 1, {{1, 0}, {1, 1}, {0, 1}, {0, 0}}}, // bottom
+    {2,  1, 0, 1, {{1, 0}, {1, 1}, {0, 1}, {0, 0}}}, // top
+    {0,  1, 1, 2, {{0, 0}, {1, 0}, {1, 1}, {0, 1}}}, // +x
+    {0, -1, 1, 2, {{0, 1}, {1, 1}, {1, 0}, {0, 0}}}, // -x
+    {1,  1, 0, 2, {{1, 1}, {1, 0}, {0, 0}, {0, 1}}}, // +y
+    {1, -1, 0, 2, {{1, 0}, {1, 1}, {0, 1}, {0, 0}}}  // -y
+  };
+
+  /// The level as a rows x columns x LAYERS grid of cube textures (NULL for air).
+  class LevelGrid {
+    public:
+      LevelGrid(const SokoBoard& board, LevelMesh::CubeTextures floorTextures,
+                LevelMesh::CubeTextures wallTextures, LevelMesh::CubeTextures targetTextures) {
+        size[0] = board.getNumberOfRows();
+        size[1] = board.getNumberOfColumns();
+        size[2] = LAYERS;
+        cubes.assign(size[0] * size[1] * size[2], (LevelMesh::CubeTextures) NULL);
+        for (int row = 0; row < size[0]; row++) {
+          for (int column = 0; column < size[1]; column++) {
+            SokoObject::Type t = board.getStatic(column, row).getType();
+            cubes[index(row, column, 0)] = t == SokoObject::TARGET ? targetTextures : floorTextures;
+            if (t == SokoObject::WALL)
+              cubes[index(row, column, 1)] = wallTextures;
+          }
+        }
+      }
+
+      /// Cube at @cell, or NULL if it is air or out of the grid.
+      LevelMesh::CubeTextures at(const int cell[3]) const {
+        for (int i = 0; i < 3; i++)
+          if (cell[i] < 0 || cell[i] >= size[i])
+            return NULL;
+        return cubes[index(cell[0], cell[1], cell[2])];
+      }
+
+      /// Hash of the textures of the cubes in the cells [@lo, @hi) (clipped to the grid).
+      std::uint64_t signature(const int lo[3], const int hi[3]) const {
+        std::uint64_t hash = 14695981039346656037ULL;
+        for (int i = 0; i < 3; i++) {
+          hash = (hash ^ std::uint64_t(lo[i])) * 1099511628211ULL;
+          hash = (hash ^ std::uint64_t(hi[i])) * 1099511628211ULL;
+        }
+        int cell[3];
+        for (cell[2] = lo[2]; cell[2] < hi[2]; cell[2]++)
+          for (cell[0] = lo[0]; cell[0] < hi[0]; cell[0]++)
+            for (cell[1] = lo[1]; cell[1] < hi[1]; cell[1]++) {
+              LevelMesh::CubeTextures cube = at(cell);
+              for (int face = 0; face < 6; face++)
+                hash = (hash ^ (cube != NULL ? cube[face] : 0)) * 1099511628211ULL;
+            }
+        return hash;
+      }
+
+      int size[3];
+
+    private:
+      int index(int x, int y, int z) const {
+        return (z * size[0] + x) * size[1] + y;
+      }
+
+      std::vector<LevelMesh::CubeTextures> cubes;
+  };
+
+  /// Emit the quad covering cells [a0, a1) x [b0, b1) of the plane at @slice.
+  void appendQuad(std::vector<MeshVertex>& out, const FaceDirection& dir, int slice,
+                  int a0, int a1, int b0, int b1) {
+    const GLfloat h = CELL_EDGE / 2.0;
+    const int bounds[2][2] = {{a0, a1}, {b0, b1}};
+    for (int i = 0; i < 4; i++) {
+      MeshVertex v;
+      v.position[dir.axis] = slice * CELL_EDGE + dir.sign * h;
+      v.position[dir.a] = bounds[0][dir.corners[i][0]] * CELL_EDGE - h;
+      v.position[dir.b] = bounds[1][dir.corners[i][1]] * CELL_EDGE - h;
+      for (int j = 0; j < 3; j++)
+        v.normal[j] = j == dir.axis ? dir.sign : 0;
+      v.texCoord[0] = bounds[0][dir.corners[i][0]] - a0;
+      v.texCoord[1] = bounds[1][dir.corners[i][1]] - b0;
+      out.push_back(v);
+    }
+  }
+
+  /// Generate the visible, merged faces of the cells [@lo, @hi) of @grid. Neighbours outside the range still hide faces.
+  void generateRange(const LevelGrid& grid, const int lo[3], const int hi[3], MeshFaces& faces) {
+    for (int face = 0; face < 6; face++) {
+      const FaceDirection& dir = FACE_DIRECTIONS[face];
+
+      // Bottoms always rest on the floor or face the ground: never visible.
+      if (dir.axis == 2 && dir.sign < 0)
+        continue;
+
+      const int width = hi[dir.a] - lo[dir.a], height = hi[dir.b] - lo[dir.b];
+      std::vector<GLuint> mask(width * height);
+      for (int slice = lo[dir.axis]; slice < hi[dir.axis]; slice++) {
+        // Texture of each visible face of this slice, 0 when there is none.
+        for (int b = 0; b < height; b++) {
+          for (int a = 0; a < width; a++) {
+            int cell[3], neighbour[3];
+            cell[dir.axis] = slice; cell[dir.a] = lo[dir.a] + a; cell[dir.b] = lo[dir.b] + b;
+            for (int i = 0; i < 3; i++)
+              neighbour[i] = cell[i] + (i == dir.axis ? dir.sign : 0);
+            LevelMesh::CubeTextures cube = grid.at(cell);
+            mask[b * width + a] = cube != NULL && grid.at(neighbour) == NULL ? cube[face] : 0;
+          }
+        }
+
+        // Greedy meshing: grow each face along a, then along b, while the texture matches.
+        for (int b = 0; b < height; b++) {
+          for (int a = 0; a < width; ) {
+            GLuint texture = mask[b * width + a];
+            if (texture == 0) {
+              a++;
+              continue;
+            }
+            int a1 = a + 1;
+            while (a1 < width && mask[b * width + a1] == texture)
+              a1++;
+            int b1 = b + 1;
+            for (; b1 < height; b1++) {
+              int i = a;
+              while (i < a1 && mask[b1 * width + i] == texture)
+                i++;
+              if (i < a1)
+                break;
+            }
+            for (int j = b; j < b1; j++)
+              for (int i = a; i < a1; i++)
+                mask[j * width + i] = 0;
+
+            appendQuad(faces[texture], dir, slice, lo[dir.a] + a, lo[dir.a] + a1, lo[dir.b] + b, lo[dir.b] + b1);
+            a = a1;
+          }
+        }
+      }
+    }
+  }
+
+  /// Cell range of the chunk at @chunkRow, @chunkColumn of @grid.
+  void chunkRange(const LevelGrid& grid, int chunkRow, int chunkColumn, int lo[3], int hi[3]) {
+    lo[0] = chunkRow * LevelMesh::CHUNK_SIZE;
+    lo[1] = chunkColumn * LevelMesh::CHUNK_SIZE;
+    lo[2] = 0;
+    hi[0] = std::min(lo[0] + LevelMesh::CHUNK_SIZE, grid.size[0]);
+    hi[1] = std::min(lo[1] + LevelMesh::CHUNK_SIZE, grid.size[1]);
+    hi[2] = grid.size[2];
+  }
+}
+
+LevelMesh::LevelMesh() {}
+
+LevelMesh::~LevelMesh() {
+  clear();
+  if (quadIndices != 0)
+    glDeleteBuffers(1, &quadIndices);
+}
+
+void LevelMesh::clear() {
+  for (Chunk& chunk : chunks) {
+    if (chunk.vbo != 0)
+      glDeleteBuffers(1, &chunk.vbo);
+    if (chunk.vao != 0)
+      glDeleteVertexArrays(1, &chunk.vao);
+  }
+  chunks.clear();
+  chunkRows = chunkColumns = 0;
+}
+
+void LevelMesh::setRenderPath(RenderPath path) {
+  clear();
+  renderPath = path;
+}
+
+void LevelMesh::reserveQuadIndices(GLsizei quads) {
+  if (quads <= quadIndexCapacity)
+    return;
+  std::vector<GLuint> indices;
+  for (GLuint quad = 0; quad < GLuint(quads); quad++) {
+    const GLuint corners[6] = {0, 1, 2, 0, 2, 3};
+    for (GLuint corner : corners)
+      indices.push_back(4 * quad + corner);
+  }
+
+  // Uploaded through the copy target: the element array binding belongs to the bound vertex array.
+  if (quadIndices == 0)
+    glGenBuffers(1, &quadIndices);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, quadIndices);
+  glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  quadIndexCapacity = quads;
+}
+
+void LevelMesh::generate(const SokoBoard& board, CubeTextures floorTextures,
+                         CubeTextures wallTextures, CubeTextures targetTextures, MeshFaces& faces) {
+  LevelGrid grid(board, floorTextures, wallTextures, targetTextures);
+  const int lo[3] = {0, 0, 0};
+  generateRange(grid, lo, grid.size, faces);
+}
+
+void LevelMesh::generateChunk(const SokoBoard& board, CubeTextures floorTextures,
+                              CubeTextures wallTextures, CubeTextures targetTextures,
+                              int chunkRow, int chunkColumn, MeshFaces& faces) {
+  LevelGrid grid(board, floorTextures, wallTextures, targetTextures);
+  int lo[3], hi[3];
+  chunkRange(grid, chunkRow, chunkColumn, lo, hi);
+  generateRange(grid, lo, hi, faces);
+}
+
+unsigned LevelMesh::build(const SokoBoard& board, CubeTextures floorTextures,
+                          CubeTextures wallTextures, CubeTextures targetTextures) {
+  LevelGrid grid(board, floorTextures, wallTextures, targetTextures);
+  int rows = (grid.size[0] + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  int columns = (grid.size[1] + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  if (rows != chunkRows || columns != chunkColumns) {
+    clear();
+    chunkRows = rows;
+    chunkColumns = columns;
+    chunks.resize(rows * columns);
+  }
+
+  unsigned rebuilt = 0;
+  for (int row = 0; row < chunkRows; row++) {
+    for (int column = 0; column < chunkColumns; column++) {
+      Chunk& chunk = chunks[row * chunkColumns + column];
+      int lo[3], hi[3];
+      chunkRange(grid, row, column, lo, hi);
+
+      // The faces of a chunk also depend on the cells around it.
+      const int outerLo[3] = {lo[0] - 1, lo[1] - 1, lo[2]};
+      const int outerHi[3] = {hi[0] + 1, hi[1] + 1, hi[2]};
+      std::uint64_t signature = grid.signature(outerLo, outerHi);
+      if (chunk.vbo != 0 && chunk.signature == signature)
+        continue;
+      chunk.signature = signature;
+      rebuilt++;
+
+      MeshFaces faces;
+      generateRange(grid, lo, hi, faces);
+
+      // Concatenate the faces of each texture into one buffer.
+      std::vector<MeshVertex> buffer;
+      chunk.batches.clear();
+      for (auto& entry : faces) {
+        MeshBatch batch = {entry.first, GLint(buffer.size()), GLsizei(entry.second.size())};
+        chunk.batches.push_back(batch);
+        buffer.insert(buffer.end(), entry.second.begin(), entry.second.end());
+      }
+      chunk.vertices = buffer.size();
+
+      std::fill(chunk.min, chunk.min + 3, 0.0f);
+      std::fill(chunk.max, chunk.max + 3, 0.0f);
+      for (unsigned i = 0; i < buffer.size(); i++) {
+        for (int j = 0; j < 3; j++) {
+          chunk.min[j] = i == 0 ? buffer[i].position[j] : std::min(chunk.min[j], buffer[i].position[j]);
+          chunk.max[j] = i == 0 ? buffer[i].position[j] : std::max(chunk.max[j], buffer[i].position[j]);
+        }
+      }
+
+      if (chunk.vbo == 0)
+        glGenBuffers(1, &chunk.vbo);
+      glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+      glBufferData(GL_ARRAY_BUFFER, buffer.size() * sizeof(MeshVertex), buffer.data(), GL_STATIC_DRAW);
+
+      if (renderPath == RENDER_PATH_SHADERS) {
+        reserveQuadIndices(chunk.vertices / 4);
+        if (chunk.vao == 0)
+          glGenVertexArrays(1, &chunk.vao);
+        glBindVertexArray(chunk.vao);
+        glEnableVertexAttribArray(ATTRIBUTE_POSITION);
+        glEnableVertexAttribArray(ATTRIBUTE_NORMAL);
+        glEnableVertexAttribArray(ATTRIBUTE_TEX_COORD);
+        glVertexAttribPointer(ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex),
+                              (const GLvoid*) offsetof(MeshVertex, position));
+        glVertexAttribPointer(ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex),
+                              (const GLvoid*) offsetof(MeshVertex, normal));
+        glVertexAttribPointer(ATTRIBUTE_TEX_COORD, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex),
+                              (const GLvoid*) offsetof(MeshVertex, texCoord));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIndices);
+        glBindVertexArray(0);
+      }
+    }
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  return rebuilt;
+}
+
+unsigned LevelMesh::draw(const Frustum* frustum) const {
+  unsigned drawn = 0;
+  if (renderPath == RENDER_PATH_SHADERS) {
+    for (const Chunk& chunk : chunks) {
+      if (chunk.vertices == 0 || (frustum != NULL && !frustum->intersects(chunk.min, chunk.max)))
+        continue;
+      drawn++;
+      glBindVertexArray(chunk.vao);
+      for (const MeshBatch& batch : chunk.batches) {
+        glBindTexture(GL_TEXTURE_2D, batch.texture);
+        glDrawElements(GL_TRIANGLES, batch.count / 4 * 6, GL_UNSIGNED_INT,
+                       (const GLvoid*) (batch.first / 4 * 6 * sizeof(GLuint)));
+      }
+    }
+    glBindVertexArray(0);
+    return drawn;
+  }
+
+  for (const Chunk& chunk : chunks) {
+    if (chunk.vertices == 0 || (frustum != NULL && !frustum->intersects(chunk.min, chunk.max)))
+      continue;
+
+    if (drawn++ == 0) {
+      glEnableClientState(GL_VERTEX_ARRAY);
+      glEnableClientState(GL_NORMAL_ARRAY);
+      glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+    glVertexPointer(3, GL_FLOAT, sizeof(MeshVertex), (const GLvoid*) offsetof(MeshVertex, position));
+    glNormalPointer(GL_FLOAT, sizeof(MeshVertex), (const GLvoid*) offsetof(MeshVertex, normal));
+    glTexCoordPointer(2, GL_FLOAT, sizeof(MeshVertex), (const GLvoid*) offsetof(MeshVertex, texCoord));
+
+    for (const MeshBatch& batch : chunk.batches) {
+      glBindTexture(GL_TEXTURE_2D, batch.texture);
+      glDrawArrays(GL_QUADS, batch.first, batch.count);
+    }
+  }
+
+  if (drawn > 0) {
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+  return drawn;
+}
+
+unsigned LevelMesh::getNumberOfQuads() const {
+  unsigned vertices = 0;
+  for (const Chunk& chunk : chunks)
+    vertices += chunk.vertices;
+  return vertices / 4;
+}
+
+unsigned LevelMesh::getNumberOfBatches() const {
+  unsigned batches = 0;
+  for (const Chunk& chunk : chunks)
+    batches += chunk.batches.size();
+  return batches;
+}
+
+unsigned LevelMesh::getNumberOfChunks() const {
+  unsigned count = 0;
+  for (const Chunk& chunk : chunks)
+    count += chunk.vertices > 0;
+  return count;
+}
+
+}
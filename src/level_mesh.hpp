@@ -0,0 +1,122 @@
+#ifndef _LEVEL_MESH_H_
+#define _LEVEL_MESH_H_
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "camera.hpp"
+#include "scene_shaders.hpp"
+#include "soko_board.hpp"
+
+namespace Sokoban {
+  /// A vertex of the level geometry, as laid out in the vertex buffer.
+  struct MeshVertex {
+    GLfloat position[3];
+    GLfloat normal[3];
+    GLfloat texCoord[2];
+  };
+
+  /// A run of quads of the vertex buffer sharing the same texture.
+  struct MeshBatch {
+    GLuint texture;
+    GLint first;
+    GLsizei count;
+  };
+
+  /// Faces of a mesh, grouped by texture.
+  typedef std::map< GLuint, std::vector<MeshVertex> > MeshFaces;
+
+  /**
+  The static geometry (floor, walls and targets) of a level, split into square
+  chunks of CHUNK_SIZE x CHUNK_SIZE cells. Each chunk has its own vertex buffer,
+  drawn with one call per texture, and a bounding box so chunks outside the view
+  frustum are skipped: the cost of a frame follows the visible area, not the
+  size of the board.
+
+  Only faces bordering air are emitted (never the bottoms), and coplanar runs of
+  faces with the same texture are merged (within a chunk) into larger quads whose
+  texture coordinates repeat once per tile.
+
+  Building again only regenerates the chunks whose cells changed.
+
+  On the shader path, each chunk is a vertex array object and its quads are
+  drawn as indexed triangles.
+
+  The geometry is built at scale 1: callers apply the game scale on the modelview matrix.
+  */
+  class LevelMesh {
+    public:
+      /// Texture IDs of the six faces of a cube: bottom, top, +x, -x, +y, -y.
+      typedef const GLuint* CubeTextures;
+
+      LevelMesh();
+      ~LevelMesh();
+
+      /// Edge of a chunk, in cells.
+      static const int CHUNK_SIZE = 16;
+
+      /// Draw with the fixed-function client arrays (the default) or with shader attributes. Drops every chunk.
+      void setRenderPath(RenderPath path);
+
+      /// Build the static geometry of @board and upload the chunks that changed. Returns their number.
+      unsigned build(const SokoBoard& board, CubeTextures floorTextures,
+            CubeTextures wallTextures, CubeTextures targetTextures);
+
+      /// Draw the chunks intersecting @frustum (NULL: all of them). The caller sets material and matrices.
+      /// Returns the number of chunks drawn.
+      unsigned draw(const Frustum* frustum = NULL) const;
+
+      /// Number of quads of the mesh.
+      unsigned getNumberOfQuads() const;
+
+      /// Number of draw calls issued by drawing all the chunks.
+      unsigned getNumberOfBatches() const;
+
+      /// Number of chunks holding geometry.
+      unsigned getNumberOfChunks() const;
+
+      /// Generate the visible, merged faces of @board into @faces. Does not touch OpenGL.
+      static void generate(const SokoBoard& board, CubeTextures floorTextures,
+            CubeTextures wallTextures, CubeTextures targetTextures, MeshFaces& faces);
+
+      /// Generate the faces of the chunk at @chunkRow, @chunkColumn only, as build() does.
+      static void generateChunk(const SokoBoard& board, CubeTextures floorTextures,
+            CubeTextures wallTextures, CubeTextures targetTextures,
+            int chunkRow, int chunkColumn, MeshFaces& faces);
+
+    private:
+      LevelMesh(const LevelMesh&);
+      LevelMesh& operator=(const LevelMesh&);
+
+      /// A chunk: its vertex buffer, draw calls (one per texture) and bounds.
+      struct Chunk {
+        GLuint vbo = 0;
+        GLuint vao = 0;
+        std::vector<MeshBatch> batches;
+        GLsizei vertices = 0;
+        GLfloat min[3], max[3];
+
+        /// Hash of the cells the faces of the chunk depend on.
+        std::uint64_t signature = 0;
+      };
+
+      /// Delete the buffers of every chunk.
+      void clear();
+
+      /// Grow the shared triangle index buffer to cover @quads quads.
+      void reserveQuadIndices(GLsizei quads);
+
+      RenderPath renderPath = RENDER_PATH_FIXED;
+
+      /// Indices of the two triangles of each quad, shared by every chunk on the shader path.
+      GLuint quadIndices = 0;
+      GLsizei quadIndexCapacity = 0;
+
+      /// Chunks in row-major order, over a chunkRows x chunkColumns grid.
+      std::vector<Chunk> chunks;
+      int chunkRows = 0, chunkColumns = 0;
+  };
+}
+
+#endif // _LEVEL_MESH_H_
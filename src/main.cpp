@@ -1,5 +1,7 @@
+#include <cstdio>
 #include <iostream>
 #include "gui.hpp"
+#include "headless.hpp"
 using namespace Sokoban;
 
 /// This function starts the game in ASCII mode. Useful for testing, but not so funny. =/
@@ -24,7 +26,47 @@ void usage() {
   std::cout << "\t- use the 'r' key to restart the current level" << std::endl;
   std::cout << "\t- use the 'u' key to undo your last move" << std::endl;
   std::cout << "\t- use the 'm' key to mute the background music" << std::endl;
+  std::cout << "\t- use the 'F3' key to show the frame times" << std::endl;
   std::cout << "\t- use the 'q' or the 'ESC' key to quit from the game at any moment" << std::endl;
+
+  std::cout << std::endl;
+  std::cout << "Options:" << std::endl;
+  std::cout << "\t--profile\tshow the frame times from the start" << std::endl;
+  std::cout << "\t--trace FILE\twrite a Chrome trace (chrome://tracing) of the frames to FILE on exit" << std::endl;
+  std::cout << "\t--animation MS\ttime a move is animated over, 0 for none (default: 300)" << std::endl;
+  std::cout << "\t--easing NAME\tspeed curve of the moves: linear, smooth or out (default: linear)" << std::endl;
+  std::cout << "\t--repeat MS\ttime between two moves of a held key (default: 100)" << std::endl;
+  std::cout << "\t--coalesce\tanimate the moves of long walks faster, as one walk" << std::endl;
+  std::cout << "\t--renderer 2d\tdraw the board from the top with the SDL renderer, for machines without OpenGL (default: 3d)" << std::endl;
+  std::cout << "\t--headless PATH\trender the level PATH, or every level in the directory PATH, with no window" << std::endl;
+  std::cout << std::endl;
+  std::cout << "Headless options:" << std::endl;
+  std::cout << "\t--output DIR\twrite one PNG per level to DIR" << std::endl;
+  std::cout << "\t--size WxH\timage size (default: 800x600)" << std::endl;
+  std::cout << "\t--threads N\tnumber of workers, each with its own context (default: one per core)" << std::endl;
+  std::cout << "\t--frames N\tframes rendered and timed per level (default: 1)" << std::endl;
+  std::cout << "\t--fixed\t\tuse the fixed-function pipeline" << std::endl;
+}
+
+/// Render levels with no window, as set by the command line. Returns the exit status.
+int startHeadlessMode(int argc, char** argv) {
+  HeadlessOptions options;
+  std::string path;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--headless") && i + 1 < argc)
+      path = argv[++i];
+    else if (!strcmp(argv[i], "--output") && i + 1 < argc)
+      options.outputDirectory = argv[++i];
+    else if (!strcmp(argv[i], "--size") && i + 1 < argc)
+      sscanf(argv[++i], "%dx%d", &options.width, &options.height);
+    else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+      options.threads = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+      options.frames = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--fixed"))
+      options.fixedFunction = true;
+  }
+  return renderLevels(findLevels(path), options) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 int main(int argc, char** argv) {
@@ -33,7 +75,38 @@ int main(int argc, char** argv) {
     return EXIT_SUCCESS;
   }
 
-  Sokoban::Gui *gui = new Sokoban::Gui();
+  for (int i = 1; i < argc; i++)
+    if (!strcmp(argv[i], "--headless"))
+      return startHeadlessMode(argc, argv);
+
+  RendererType rendererType = RENDERER_3D;
+  for (int i = 1; i + 1 < argc; i++)
+    if (!strcmp(argv[i], "--renderer") && !strcmp(argv[i + 1], "2d"))
+      rendererType = RENDERER_2D;
+
+  Sokoban::Gui *gui = new Sokoban::Gui(rendererType);
+  double duration = Simulation::ANIMATION_DURATION;
+  Easing easing = EASING_LINEAR;
+  double repeat = InputQueue::REPEAT_INTERVAL;
+  bool coalesce = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--profile"))
+      gui->setProfilerOverlay(true);
+    else if (!strcmp(argv[i], "--trace") && i + 1 < argc)
+      gui->setTracePath(argv[++i]);
+    else if (!strcmp(argv[i], "--animation") && i + 1 < argc)
+      duration = atoi(argv[++i]) / 1000.0;
+    else if (!strcmp(argv[i], "--easing") && i + 1 < argc) {
+      i++;
+      easing = !strcmp(argv[i], "smooth") ? EASING_SMOOTH : !strcmp(argv[i], "out") ? EASING_OUT : EASING_LINEAR;
+    }
+    else if (!strcmp(argv[i], "--repeat") && i + 1 < argc)
+      repeat = atoi(argv[++i]) / 1000.0;
+    else if (!strcmp(argv[i], "--coalesce"))
+      coalesce = true;
+  }
+  gui->setAnimation(duration, easing);
+  gui->setKeyRepeat(repeat, coalesce);
   gui->gameLoop();
   //startASCIIMode();
   return EXIT_SUCCESS;
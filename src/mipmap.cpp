@@ -0,0 +1,280 @@
+#include "mipmap.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace Sokoban {
+
+namespace {
+  /// Half width of the Kaiser filter, in texels of the smaller level.
+  const double KAISER_RADIUS = 3.0;
+
+  /// Shape of the Kaiser window: larger is smoother, with less ringing.
+  const double KAISER_ALPHA = 4.0;
+
+  /// Fewest rows worth handing to a thread. Smaller levels are built on the calling thread.
+  const int ROWS_PER_THREAD = 64;
+
+  /// Zeroth order modified Bessel function of the first kind.
+  double bessel0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32 && term > sum * 1e-12; k++) {
+      term *= (x / (2 * k)) * (x / (2 * k));
+      sum += term;
+    }
+    return sum;
+  }
+
+  double sinc(double x) {
+    if (std::fabs(x) < 1e-6)
+      return 1.0;
+    return std::sin(M_PI * x) / (M_PI * x);
+  }
+
+  /// Kaiser windowed sinc at @t texels of the smaller level from the center.
+  double kaiser(double t) {
+    static const double scale = 1 / bessel0(KAISER_ALPHA);
+    if (std::fabs(t) >= KAISER_RADIUS)
+      return 0.0;
+    double r = t / KAISER_RADIUS;
+    return sinc(t) * bessel0(KAISER_ALPHA * std::sqrt(1 - r * r)) * scale;
+  }
+
+  /// Source texel @i of an axis of @size texels, wrapped around or clamped to the edges.
+  int sourceIndex(int i, int size, bool wrap) {
+    return wrap ? ((i % size) + size) % size : std::min(std::max(i, 0), size - 1);
+  }
+
+  /**
+  Normalized weights along one axis: texel x of the next level sums @count[x]
+  consecutive source texels from @start[x], weighted from @weights[@first[x]].
+  Taps may reach @before texels before the source and @after texels past it.
+  */
+  struct FilterTable {
+    std::vector<int> start, count, first;
+    std::vector<float> weights;
+    int before = 0, after = 0;
+  };
+
+  FilterTable buildTable(int sourceSize, int targetSize, MipFilter filter) {
+    FilterTable table;
+    double scale = double(sourceSize) / targetSize;
+    std::vector<double> weights;
+    for (int x = 0; x < targetSize; x++) {
+      // Texel edges are at integer source coordinates.
+      double center = (x + 0.5) * scale;
+      double start = filter == MIP_FILTER_BOX ? x * scale : center - KAISER_RADIUS * scale;
+      double end = filter == MIP_FILTER_BOX ? (x + 1) * scale : center + KAISER_RADIUS * scale;
+      int first = int(std::floor(start)), last = int(std::ceil(end));
+
+      // Halving exactly, every texel gets the same weights: compute them once.
+      if (x == 0 || sourceSize != 2 * targetSize) {
+        weights.clear();
+        for (int i = first; i < last; i++)
+          weights.push_back(filter == MIP_FILTER_BOX ? std::min(end, i + 1.0) - std::max(start, double(i))
+                                                     : kaiser((i + 0.5 - center) / scale));
+      }
+      double total = 0;
+      for (double weight : weights)
+        total += weight;
+
+      table.start.push_back(first);
+      table.count.push_back(weights.size());
+      table.first.push_back(table.weights.size());
+      for (double weight : weights)
+        table.weights.push_back(float(weight / total));
+      table.before = std::max(table.before, -first);
+      table.after = std::max(table.after, first + int(weights.size()) - sourceSize);
+    }
+    return table;
+  }
+
+  /// Run @body over [0, @rows) in bands, on as many threads as the size is worth.
+  template <typename Body>
+  void parallelRows(int rows, const Body& body) {
+    int threads = std::min(int(std::max(1u, std::thread::hardware_concurrency())), rows / ROWS_PER_THREAD);
+    if (threads <= 1) {
+      body(0, rows);
+      return;
+    }
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++)
+      workers.push_back(std::thread(body, rows * t / threads, rows * (t + 1) / threads));
+    body(0, rows / threads);
+    for (std::thread& worker : workers)
+      worker.join();
+  }
+
+#ifdef __SSE2__
+  /// One RGBA texel as four floats.
+  typedef __m128 Texel;
+
+  inline Texel loadTexel(const unsigned char* p) {
+    int value;
+    memcpy(&value, p, 4);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i wide = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero), zero);
+    return _mm_cvtepi32_ps(wide);
+  }
+
+  inline Texel loadTexel(const float* p) {
+    return _mm_loadu_ps(p);
+  }
+
+  inline void storeTexel(Texel texel, float* p) {
+    _mm_storeu_ps(p, texel);
+  }
+
+  /// Round and saturate to bytes.
+  inline void storeTexel(Texel texel, unsigned char* p) {
+    __m128i wide = _mm_cvtps_epi32(texel);
+    wide = _mm_packs_epi32(wide, wide);
+    int value = _mm_cvtsi128_si32(_mm_packus_epi16(wide, wide));
+    memcpy(p, &value, 4);
+  }
+
+  inline Texel zeroTexel() {
+    return _mm_setzero_ps();
+  }
+
+  inline Texel multiplyAdd(Texel sum, Texel texel, float weight) {
+    return _mm_add_ps(sum, _mm_mul_ps(texel, _mm_set1_ps(weight)));
+  }
+#else
+  struct Texel {
+    float c[4];
+  };
+
+  template <typename T>
+  inline Texel loadTexel(const T* p) {
+    Texel texel = {{float(p[0]), float(p[1]), float(p[2]), float(p[3])}};
+    return texel;
+  }
+
+  inline void storeTexel(const Texel& texel, float* p) {
+    memcpy(p, texel.c, sizeof(texel.c));
+  }
+
+  inline void storeTexel(const Texel& texel, unsigned char* p) {
+    for (int i = 0; i < 4; i++)
+      p[i] = (unsigned char) std::min(std::max(std::nearbyint(texel.c[i]), 0.0f), 255.0f);
+  }
+
+  inline Texel zeroTexel() {
+    Texel texel = {{0, 0, 0, 0}};
+    return texel;
+  }
+
+  inline Texel multiplyAdd(Texel sum, const Texel& texel, float weight) {
+    for (int i = 0; i < 4; i++)
+      sum.c[i] += texel.c[i] * weight;
+    return sum;
+  }
+#endif
+
+  /// Exact 2x2 average, for levels with even sides.
+  void downsampleEvenBox(const Image& source, Image& target) {
+    const int sourceStride = 4 * source.width;
+    parallelRows(target.height, [&](int begin, int end) {
+      for (int y = begin; y < end; y++) {
+        const unsigned char* row0 = &source.pixels[2 * y * sourceStride];
+        const unsigned char* row1 = row0 + sourceStride;
+        unsigned char* out = &target.pixels[4 * y * target.width];
+        int x = 0;
+#ifdef __SSE2__
+        // Two texels of the target from four of each source row.
+        const __m128i zero = _mm_setzero_si128(), two = _mm_set1_epi16(2);
+        for (; x + 2 <= target.width; x += 2) {
+          __m128i top = _mm_loadu_si128((const __m128i*) (row0 + 8 * x));
+          __m128i bottom = _mm_loadu_si128((const __m128i*) (row1 + 8 * x));
+          __m128i left = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+          __m128i right = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+          left = _mm_add_epi16(left, _mm_srli_si128(left, 8));
+          right = _mm_add_epi16(right, _mm_srli_si128(right, 8));
+          __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(left, right), two), 2);
+          _mm_storel_epi64((__m128i*) (out + 4 * x), _mm_packus_epi16(sum, sum));
+        }
+#endif
+        for (; x < target.width; x++)
+          for (int c = 0; c < 4; c++)
+            out[4 * x + c] = (unsigned char) ((row0[8 * x + c] + row0[8 * x + 4 + c] +
+                                               row1[8 * x + c] + row1[8 * x + 4 + c] + 2) / 4);
+      }
+    });
+  }
+
+  /// Separable resampling with @filter: rows first, into floats, then columns.
+  void downsampleSeparable(const Image& source, Image& target, MipFilter filter, bool wrap) {
+    const FilterTable columns = buildTable(source.width, target.width, filter);
+    const FilterTable rows = buildTable(source.height, target.height, filter);
+
+    std::vector<float> horizontal(4 * target.width * source.height);
+    parallelRows(source.height, [&](int begin, int end) {
+      // The row in floats, extended past its edges so the taps of every texel are consecutive.
+      std::vector<float> padded(4 * (columns.before + source.width + columns.after));
+      for (int y = begin; y < end; y++) {
+        const unsigned char* in = &source.pixels[4 * y * source.width];
+        for (int i = -columns.before; i < source.width + columns.after; i++)
+          storeTexel(loadTexel(in + 4 * sourceIndex(i, source.width, wrap)), &padded[4 * (i + columns.before)]);
+
+        float* out = &horizontal[4 * y * target.width];
+        for (int x = 0; x < target.width; x++) {
+          const float* taps = &padded[4 * (columns.start[x] + columns.before)];
+          const float* weights = &columns.weights[columns.first[x]];
+          Texel sum = zeroTexel();
+          for (int k = 0; k < columns.count[x]; k++)
+            sum = multiplyAdd(sum, loadTexel(taps + 4 * k), weights[k]);
+          storeTexel(sum, out + 4 * x);
+        }
+      }
+    });
+
+    parallelRows(target.height, [&](int begin, int end) {
+      std::vector<const float*> taps;
+      for (int y = begin; y < end; y++) {
+        taps.clear();
+        for (int k = 0; k < rows.count[y]; k++)
+          taps.push_back(&horizontal[4 * sourceIndex(rows.start[y] + k, source.height, wrap) * target.width]);
+        const float* weights = &rows.weights[rows.first[y]];
+
+        unsigned char* out = &target.pixels[4 * y * target.width];
+        for (int x = 0; x < target.width; x++) {
+          Texel sum = zeroTexel();
+          for (unsigned k = 0; k < taps.size(); k++)
+            sum = multiplyAdd(sum, loadTexel(taps[k] + 4 * x), weights[k]);
+          storeTexel(sum, out + 4 * x);
+        }
+      }
+    });
+  }
+
+  void downsample(const Image& source, Image& target, MipFilter filter, bool wrap) {
+    target.width = nextMipSize(source.width);
+    target.height = nextMipSize(source.height);
+    target.pixels.resize(4 * target.width * target.height);
+
+    if (filter == MIP_FILTER_BOX && source.width % 2 == 0 && source.height % 2 == 0)
+      downsampleEvenBox(source, target);
+    else
+      downsampleSeparable(source, target, filter, wrap);
+  }
+}
+
+void buildMipmaps(const Image& base, std::vector<Image>& levels, MipFilter filter, bool wrap) {
+  levels.clear();
+  if (base.pixels.empty())
+    return;
+
+  levels.push_back(base);
+  while (levels.back().width > 1 || levels.back().height > 1) {
+    Image next;
+    downsample(levels.back(), next, filter, wrap);
+    levels.push_back(next);
+  }
+}
+
+}
@@ -0,0 +1,33 @@
+#ifndef _MIPMAP_H_
+#define _MIPMAP_H_
+
+#include <vector>
+#include "texture_cache.hpp"
+
+namespace Sokoban {
+  /// Filters to build mip levels with.
+  enum MipFilter {
+    /// Average of the covered texels. Cheap, and its footprint stays within one texel of the level above.
+    MIP_FILTER_BOX = 0,
+    /// Kaiser windowed sinc: sharper levels with less aliasing, but a wider footprint.
+    MIP_FILTER_KAISER = 1
+  };
+
+  /// Size of the mip level after one of @size texels: halved, rounding down, at least 1.
+  inline int nextMipSize(int size) {
+    return size > 1 ? size / 2 : 1;
+  }
+
+  /**
+  Build the full mip chain of @base into @levels: a copy of @base first, then
+  every level halving the previous one (see nextMipSize()) down to 1x1.
+  Non power of two sizes are kept as they are, nothing is rescaled.
+
+  @wrap makes the filter wrap around the edges, for repeating textures;
+  otherwise it clamps to them. Large levels are split across threads.
+  */
+  void buildMipmaps(const Image& base, std::vector<Image>& levels,
+        MipFilter filter = MIP_FILTER_KAISER, bool wrap = false);
+}
+
+#endif // _MIPMAP_H_
@@ -0,0 +1,236 @@
+#include "object_batch.hpp"
+#include <cstddef>
+#include <iterator>
+
+namespace Sokoban {
+
+namespace {
+  /// Normals of the cube faces: bottom, top, +x, -x, +y, -y.
+  const GLfloat NORMALS[6][3] = {
+    {0, 0, -1}, {0, 0, 1}, {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}
+  };
+
+  /// Corners of the faces of a cube of edge 2 centered at the origin.
+  const GLfloat CORNERS[6][4][3] = {
+    {{ 1, -1, -1}, { 1,  1, -1}, {-1,  1, -1}, {-1, -1, -1}}, // bottom
+    {{ 1, -1,  1}, { 1,  1,  1}, {-1,  1,  1}, {-1, -1,  1}}, // top
+    {{ 1, -1, -1}, { 1,  1, -1}, { 1,  1,  1}, { 1, -1,  1}}, // +x
+    {{-1, -1,  1}, {-1,  1,  1}, {-1,  1, -1}, {-1, -1, -1}}, // -x
+    {{ 1,  1,  1}, { 1,  1, -1}, {-1,  1, -1}, {-1,  1,  1}}, // +y
+    {{ 1, -1, -1}, { 1, -1,  1}, {-1, -1,  1}, {-1, -1, -1}}  // -y
+  };
+
+  /// Texture coordinates of the corners, inside the face's atlas region.
+  const GLfloat TEX_COORDS[6][4][2] = {
+    {{1, 0}, {1, 1}, {0, 1}, {0, 0}},
+    {{1, 0}, {1, 1}, {0, 1}, {0, 0}},
+    {{0, 0}, {1, 0}, {1, 1}, {0, 1}},
+    {{0, 1}, {1, 1}, {1, 0}, {0, 0}},
+    {{1, 1}, {1, 0}, {0, 0}, {0, 1}},
+    {{1, 0}, {1, 1}, {0, 1}, {0, 0}}
+  };
+
+  /// Objects rest on the floor: their bottom face is never visible.
+  const int FIRST_VISIBLE_FACE = 1;
+
+  const GLubyte WHITE[4] = {255, 255, 255, 255};
+  const GLubyte RED[4] = {255, 0, 0, 255};
+
+  /// A vertex of the cube of the instanced path: a corner of the edge 2 cube and its face.
+  struct CubeVertex {
+    GLfloat corner[3];
+    GLfloat normal[3];
+    GLfloat texCoord[2];
+    GLfloat face;
+  };
+
+  /// Triangles of the visible faces of the instanced cube.
+  const GLsizei CUBE_INDICES = (6 - FIRST_VISIBLE_FACE) * 6;
+}
+
+ObjectBatch::ObjectBatch() {}
+
+ObjectBatch::~ObjectBatch() {
+  if (vbo != 0)
+    glDeleteBuffers(1, &vbo);
+  if (cubeVbo != 0)
+    glDeleteBuffers(1, &cubeVbo);
+  if (cubeIndices != 0)
+    glDeleteBuffers(1, &cubeIndices);
+  if (vao != 0)
+    glDeleteVertexArrays(1, &vao);
+}
+
+void ObjectBatch::setRenderPath(RenderPath path) {
+  renderPath = path;
+}
+
+void ObjectBatch::setSkin(SokoObject::Type type, const AtlasRegion regions[6]) {
+  skins[type].assign(regions, regions + 6);
+}
+
+std::vector<GLfloat> ObjectBatch::getSkinTable() const {
+  std::vector<GLfloat> table;
+  for (const auto& skin : skins) {
+    for (const AtlasRegion& region : skin.second) {
+      table.push_back(region.u0);
+      table.push_back(region.v0);
+      table.push_back(region.u1);
+      table.push_back(region.v1);
+    }
+  }
+  return table;
+}
+
+void ObjectBatch::createInstancedCube() {
+  std::vector<CubeVertex> cube;
+  std::vector<GLushort> indices;
+  for (int face = FIRST_VISIBLE_FACE; face < 6; face++) {
+    GLushort first = cube.size();
+    for (int corner = 0; corner < 4; corner++) {
+      CubeVertex v;
+      for (int i = 0; i < 3; i++) {
+        v.corner[i] = CORNERS[face][corner][i];
+        v.normal[i] = NORMALS[face][i];
+      }
+      v.texCoord[0] = TEX_COORDS[face][corner][0];
+      v.texCoord[1] = TEX_COORDS[face][corner][1];
+      v.face = face;
+      cube.push_back(v);
+    }
+    const GLushort corners[6] = {0, 1, 2, 0, 2, 3};
+    for (GLushort corner : corners)
+      indices.push_back(first + corner);
+  }
+
+  glGenVertexArrays(1, &vao);
+  glGenBuffers(1, &cubeVbo);
+  glGenBuffers(1, &cubeIndices);
+  glGenBuffers(1, &vbo);
+  glBindVertexArray(vao);
+
+  glBindBuffer(GL_ARRAY_BUFFER, cubeVbo);
+  glBufferData(GL_ARRAY_BUFFER, cube.size() * sizeof(CubeVertex), cube.data(), GL_STATIC_DRAW);
+  glEnableVertexAttribArray(ATTRIBUTE_POSITION);
+  glEnableVertexAttribArray(ATTRIBUTE_NORMAL);
+  glEnableVertexAttribArray(ATTRIBUTE_TEX_COORD);
+  glEnableVertexAttribArray(ATTRIBUTE_FACE);
+  glVertexAttribPointer(ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(CubeVertex), (const GLvoid*) offsetof(CubeVertex, corner));
+  glVertexAttribPointer(ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(CubeVertex), (const GLvoid*) offsetof(CubeVertex, normal));
+  glVertexAttribPointer(ATTRIBUTE_TEX_COORD, 2, GL_FLOAT, GL_FALSE, sizeof(CubeVertex), (const GLvoid*) offsetof(CubeVertex, texCoord));
+  glVertexAttribPointer(ATTRIBUTE_FACE, 1, GL_FLOAT, GL_FALSE, sizeof(CubeVertex), (const GLvoid*) offsetof(CubeVertex, face));
+
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glEnableVertexAttribArray(ATTRIBUTE_INSTANCE_POSITION);
+  glEnableVertexAttribArray(ATTRIBUTE_INSTANCE_SKIN);
+  glEnableVertexAttribArray(ATTRIBUTE_INSTANCE_TINT);
+  glVertexAttribPointer(ATTRIBUTE_INSTANCE_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(ObjectInstanceVertex),
+                        (const GLvoid*) offsetof(ObjectInstanceVertex, position));
+  glVertexAttribPointer(ATTRIBUTE_INSTANCE_SKIN, 1, GL_FLOAT, GL_FALSE, sizeof(ObjectInstanceVertex),
+                        (const GLvoid*) offsetof(ObjectInstanceVertex, skin));
+  glVertexAttribPointer(ATTRIBUTE_INSTANCE_TINT, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ObjectInstanceVertex),
+                        (const GLvoid*) offsetof(ObjectInstanceVertex, tint));
+  glVertexAttribDivisor(ATTRIBUTE_INSTANCE_POSITION, 1);
+  glVertexAttribDivisor(ATTRIBUTE_INSTANCE_SKIN, 1);
+  glVertexAttribDivisor(ATTRIBUTE_INSTANCE_TINT, 1);
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeIndices);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ObjectBatch::update(const std::vector<ObjectInstance>& instances, GLfloat edge) {
+  if (renderPath == RENDER_PATH_SHADERS) {
+    // The edge is a uniform of the objects shader: only the instances are streamed.
+    if (vao == 0)
+      createInstancedCube();
+    instanceVertices.clear();
+    for (const ObjectInstance& instance : instances) {
+      auto skin = skins.find(instance.type);
+      if (skin == skins.end())
+        continue;
+      const GLubyte* tint = instance.onTarget ? RED : WHITE;
+      ObjectInstanceVertex v = {
+        {instance.position[0], instance.position[1], instance.position[2]},
+        GLfloat(std::distance(skins.begin(), skin)),
+        {tint[0], tint[1], tint[2], tint[3]}
+      };
+      instanceVertices.push_back(v);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, instanceVertices.size() * sizeof(ObjectInstanceVertex), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instanceVertices.size() * sizeof(ObjectInstanceVertex), instanceVertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    count = instanceVertices.size();
+    return;
+  }
+
+  const GLfloat h = edge / 2.0;
+  vertices.clear();
+
+  for (const ObjectInstance& instance : instances) {
+    auto skin = skins.find(instance.type);
+    if (skin == skins.end())
+      continue;
+
+    const GLubyte* color = instance.onTarget ? RED : WHITE;
+    for (int face = FIRST_VISIBLE_FACE; face < 6; face++) {
+      const AtlasRegion& region = skin->second[face];
+      for (int corner = 0; corner < 4; corner++) {
+        ObjectVertex v;
+        for (int i = 0; i < 3; i++) {
+          v.position[i] = instance.position[i] + h * CORNERS[face][corner][i];
+          v.normal[i] = NORMALS[face][i];
+        }
+        v.texCoord[0] = region.u0 + TEX_COORDS[face][corner][0] * (region.u1 - region.u0);
+        v.texCoord[1] = region.v0 + TEX_COORDS[face][corner][1] * (region.v1 - region.v0);
+        for (int i = 0; i < 4; i++)
+          v.color[i] = color[i];
+        vertices.push_back(v);
+      }
+    }
+  }
+
+  if (vbo == 0)
+    glGenBuffers(1, &vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  // Orphan the previous storage so the driver does not stall on last frame's draw.
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(ObjectVertex), NULL, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(ObjectVertex), vertices.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  count = vertices.size();
+}
+
+void ObjectBatch::draw() const {
+  if (vbo == 0 || count == 0)
+    return;
+
+  if (renderPath == RENDER_PATH_SHADERS) {
+    glBindVertexArray(vao);
+    glDrawElementsInstanced(GL_TRIANGLES, CUBE_INDICES, GL_UNSIGNED_SHORT, NULL, count);
+    glBindVertexArray(0);
+    return;
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_NORMAL_ARRAY);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+  glEnableClientState(GL_COLOR_ARRAY);
+  glVertexPointer(3, GL_FLOAT, sizeof(ObjectVertex), (const GLvoid*) offsetof(ObjectVertex, position));
+  glNormalPointer(GL_FLOAT, sizeof(ObjectVertex), (const GLvoid*) offsetof(ObjectVertex, normal));
+  glTexCoordPointer(2, GL_FLOAT, sizeof(ObjectVertex), (const GLvoid*) offsetof(ObjectVertex, texCoord));
+  glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(ObjectVertex), (const GLvoid*) offsetof(ObjectVertex, color));
+
+  glDrawArrays(GL_QUADS, 0, count);
+
+  glDisableClientState(GL_COLOR_ARRAY);
+  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState(GL_NORMAL_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glColor4ubv(WHITE);
+}
+
+}
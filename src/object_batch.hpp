@@ -0,0 +1,99 @@
+#ifndef _OBJECT_BATCH_H_
+#define _OBJECT_BATCH_H_
+
+#include <GL/glew.h>
+#include <map>
+#include <vector>
+#include "scene_shaders.hpp"
+#include "soko_object.hpp"
+#include "texture_atlas.hpp"
+
+namespace Sokoban {
+  /// Per-frame state of one dynamic object to be drawn.
+  struct ObjectInstance {
+    /// Center of the cube, at scale 1.
+    GLfloat position[3];
+
+    /// The type of the object, which selects its faces in the atlas.
+    SokoObject::Type type;
+
+    /// True if the object should be tinted as resolved (a box on a target).
+    bool onTarget;
+  };
+
+  /// A vertex of the dynamic objects batch.
+  struct ObjectVertex {
+    GLfloat position[3];
+    GLfloat normal[3];
+    GLfloat texCoord[2];
+    GLubyte color[4];
+  };
+
+  /// A per-instance record of the instanced (shader) path.
+  struct ObjectInstanceVertex {
+    GLfloat position[3];
+    GLfloat skin;
+    GLubyte tint[4];
+  };
+
+  /**
+  Draws every dynamic object (boxes and the character) as cubes textured from
+  one atlas, with a single draw call.
+
+  The instances are uploaded once per frame. The fixed-function pipeline has no
+  instancing, so there the cubes are expanded into a streaming vertex buffer and
+  the on-target tint travels as a vertex color instead of material state.
+  On the shader path one cube is kept in a static buffer and drawn instanced:
+  only a position, a skin and a tint per object are streamed, and the skins'
+  atlas regions live in the objects shader (see getSkinTable()).
+  */
+  class ObjectBatch {
+    public:
+      ObjectBatch();
+      ~ObjectBatch();
+
+      /// Draw with expanded client arrays (the default) or instanced with shader attributes.
+      void setRenderPath(RenderPath path);
+
+      /// Use the six atlas @regions (faces: bottom, top, +x, -x, +y, -y) for objects of @type.
+      void setSkin(SokoObject::Type type, const AtlasRegion regions[6]);
+
+      /// Atlas regions of every skin (u0, v0, u1, v1 per face), in the order the instances refer to them.
+      std::vector<GLfloat> getSkinTable() const;
+
+      /// Replace the instances to draw with @instances, as cubes of @edge.
+      void update(const std::vector<ObjectInstance>& instances, GLfloat edge);
+
+      /// Draw all the instances. The caller binds the atlas and sets matrices (or the objects shader).
+      void draw() const;
+
+    private:
+      ObjectBatch(const ObjectBatch&);
+      ObjectBatch& operator=(const ObjectBatch&);
+
+      /// Create the cube buffers and the vertex array of the instanced path.
+      void createInstancedCube();
+
+      /// Atlas regions of the six faces of each object type.
+      std::map< SokoObject::Type, std::vector<AtlasRegion> > skins;
+
+      RenderPath renderPath = RENDER_PATH_FIXED;
+
+      /// Expanded vertices, kept to reuse their storage between frames.
+      std::vector<ObjectVertex> vertices;
+
+      /// Instance records, kept to reuse their storage between frames.
+      std::vector<ObjectInstanceVertex> instanceVertices;
+
+      /// The streaming vertex buffer object (vertices or instance records).
+      GLuint vbo = 0;
+
+      /// The cube of the instanced path: vertices, triangle indices and vertex array.
+      GLuint cubeVbo = 0, cubeIndices = 0, vao = 0;
+
+      /// Number of vertices (or instances) uploaded by the last update().
+      GLsizei count = 0;
+  };
+}
+
+#endif // _OBJECT_BATCH_H_
@@ -0,0 +1,143 @@
+#include "offscreen.hpp"
+#include <EGL/eglext.h>
+#include <png.h>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+
+namespace Sokoban {
+
+namespace {
+  /// Return the surfaceless display if the EGL implementation has one, else the default display.
+  EGLDisplay surfacelessDisplay() {
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (extensions != NULL && strstr(extensions, "EGL_MESA_platform_surfaceless") != NULL && getPlatformDisplay != NULL)
+      return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+
+  /// glewInit() writes global function pointers: one thread at a time.
+  std::mutex glewMutex;
+}
+
+bool savePng(const std::string& path, const Image& image) {
+  png_image png;
+  memset(&png, 0, sizeof(png));
+  png.version = PNG_IMAGE_VERSION;
+  png.width = image.width;
+  png.height = image.height;
+  png.format = PNG_FORMAT_RGBA;
+  if (!png_image_write_to_file(&png, path.c_str(), 0, image.pixels.data(), 4 * image.width, NULL)) {
+    std::cout << "INFO: Unable to write " << path << ": " << png.message << std::endl;
+    return false;
+  }
+  return true;
+}
+
+OffscreenContext::OffscreenContext() {}
+
+OffscreenContext::~OffscreenContext() {
+  if (context == EGL_NO_CONTEXT)
+    return;
+  if (framebuffer != 0) {
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(2, renderbuffers);
+  }
+  // The display stays initialized: other threads may still render on it.
+  eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  eglDestroyContext(display, context);
+  eglReleaseThread();
+}
+
+bool OffscreenContext::create(int width, int height, bool fixedFunction) {
+  this->width = width;
+  this->height = height;
+
+  display = surfacelessDisplay();
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL) || !eglBindAPI(EGL_OPENGL_API)) {
+    std::cout << "INFO: Unable to initialize EGL (error 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+    return false;
+  }
+  // Nothing is drawn to an EGL surface: surfaceless displays may have no config at all.
+  const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+  EGLConfig config = EGL_NO_CONFIG_KHR;
+  EGLint configs = 0;
+  if (!eglChooseConfig(display, configAttributes, &config, 1, &configs) || configs == 0)
+    config = EGL_NO_CONFIG_KHR;
+
+  /* 3.3 core for the shaders, else a legacy one for the fixed-function pipeline, as on screen. */
+  if (!fixedFunction) {
+    const EGLint coreAttributes[] = {
+      EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE
+    };
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, coreAttributes);
+  }
+  renderPath = context != EGL_NO_CONTEXT ? RENDER_PATH_SHADERS : RENDER_PATH_FIXED;
+  if (context == EGL_NO_CONTEXT) {
+    const EGLint legacyAttributes[] = {EGL_CONTEXT_MAJOR_VERSION, 2, EGL_CONTEXT_MINOR_VERSION, 1, EGL_NONE};
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, legacyAttributes);
+  }
+  if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+    std::cout << "INFO: Unable to create a surfaceless OpenGL context (error 0x" << std::hex << eglGetError()
+              << std::dec << ")" << std::endl;
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(glewMutex);
+    glewExperimental = GL_TRUE;
+    GLenum glewError = glewInit();
+    // GLX builds of GLEW load every GL entry point, then fail on the missing X display.
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    if (glewError == GLEW_ERROR_NO_GLX_DISPLAY)
+      glewError = GLEW_OK;
+#endif
+    if (glewError != GLEW_OK) {
+      std::cout << "INFO: GLEW could not be initialized: " << glewGetErrorString(glewError) << std::endl;
+      return false;
+    }
+    glGetError();
+  }
+
+  glGenFramebuffers(1, &framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glGenRenderbuffers(2, renderbuffers);
+  glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+  glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    std::cout << "INFO: Incomplete offscreen framebuffer" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+RenderPath OffscreenContext::getRenderPath() const {
+  return renderPath;
+}
+
+void OffscreenContext::readPixels(Image& image) const {
+  image.width = width;
+  image.height = height;
+  image.pixels.resize(4 * width * height);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+
+  // OpenGL rows go bottom up.
+  std::vector<unsigned char> row(4 * width);
+  for (int y = 0; y < height / 2; y++) {
+    unsigned char* top = &image.pixels[4 * width * y];
+    unsigned char* bottom = &image.pixels[4 * width * (height - 1 - y)];
+    memcpy(row.data(), top, row.size());
+    memcpy(top, bottom, row.size());
+    memcpy(bottom, row.data(), row.size());
+  }
+}
+
+}
@@ -0,0 +1,52 @@
+#ifndef _OFFSCREEN_H_
+#define _OFFSCREEN_H_
+
+#include <EGL/egl.h>
+#include <GL/glew.h>
+#include <string>
+#include "scene_shaders.hpp"
+#include "texture_cache.hpp"
+
+namespace Sokoban {
+  /// Write @image (RGBA, top row first) to @path as a PNG. Returns false if it could not be written.
+  bool savePng(const std::string& path, const Image& image);
+
+  /**
+  An OpenGL context with no window, rendering to a framebuffer object.
+
+  The context comes from EGL on a surfaceless display (Mesa's llvmpipe works
+  without any GPU). It is current on the thread that created it, so every
+  thread rendering offscreen needs its own.
+  */
+  class OffscreenContext {
+    public:
+      OffscreenContext();
+
+      /// Destroy the framebuffer and the context.
+      ~OffscreenContext();
+
+      /// Create a context current on the calling thread, drawing to a @width x @height framebuffer.
+      /// Asks for 3.3 core unless @fixedFunction, then falls back to a legacy context. Returns false on failure.
+      bool create(int width, int height, bool fixedFunction = false);
+
+      /// Pipeline the context can render with.
+      RenderPath getRenderPath() const;
+
+      /// Copy the framebuffer to @image, top row first.
+      void readPixels(Image& image) const;
+
+    private:
+      OffscreenContext(const OffscreenContext&);
+      OffscreenContext& operator=(const OffscreenContext&);
+
+      EGLDisplay display = EGL_NO_DISPLAY;
+      EGLContext context = EGL_NO_CONTEXT;
+      GLuint framebuffer = 0;
+      GLuint renderbuffers[2] = {0, 0};
+      int width = 0;
+      int height = 0;
+      RenderPath renderPath = RENDER_PATH_FIXED;
+  };
+}
+
+#endif // _OFFSCREEN_H_
@@ -0,0 +1,125 @@
+#include "profiler.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace Sokoban {
+
+namespace {
+  /// Small, stable id of the calling thread, in the order threads first record.
+  unsigned threadId() {
+    static std::atomic<unsigned> next(1);
+    static thread_local unsigned id = next.fetch_add(1);
+    return id;
+  }
+
+  /// Value at @p percent of the sorted @values.
+  double percentile(const std::vector<double>& values, double p) {
+    unsigned i = std::min<unsigned>(values.size() - 1, unsigned(p / 100 * values.size()));
+    return values[i];
+  }
+
+  /// Write @text as a JSON string.
+  void writeString(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c; c++) {
+      if (*c == '"' || *c == '\\')
+        out << '\\';
+      out << *c;
+    }
+    out << '"';
+  }
+}
+
+Profiler& Profiler::instance() {
+  static Profiler profiler;
+  return profiler;
+}
+
+Profiler::Profiler() : epoch(std::chrono::steady_clock::now()), head(0) {
+  for (Slot& slot : slots)
+    slot.sequence.store(0, std::memory_order_relaxed);
+}
+
+uint64_t Profiler::now() const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::record(const char* name, uint64_t start, uint64_t duration) {
+  uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = slots[index % CAPACITY];
+  slot.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.thread.store(threadId(), std::memory_order_relaxed);
+  slot.start.store(start, std::memory_order_relaxed);
+  slot.duration.store(duration, std::memory_order_relaxed);
+  slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+bool Profiler::read(uint64_t index, ProfileSample& sample) const {
+  const Slot& slot = slots[index % CAPACITY];
+  if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+    return false;
+  sample.name = slot.name.load(std::memory_order_relaxed);
+  sample.thread = slot.thread.load(std::memory_order_relaxed);
+  sample.start = slot.start.load(std::memory_order_relaxed);
+  sample.duration = slot.duration.load(std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot.sequence.load(std::memory_order_relaxed) == index + 1;
+}
+
+void Profiler::collect(std::vector<ProfileSample>& samples) const {
+  samples.clear();
+  uint64_t end = head.load(std::memory_order_acquire);
+  uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+  ProfileSample sample;
+  for (uint64_t i = begin; i < end; i++)
+    if (read(i, sample))
+      samples.push_back(sample);
+}
+
+ProfileStatistics Profiler::statistics(const char* name, unsigned count) const {
+  std::vector<double> durations;
+  uint64_t end = head.load(std::memory_order_acquire);
+  uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+  ProfileSample sample;
+  for (uint64_t i = end; i > begin && durations.size() < count; i--)
+    if (read(i - 1, sample) && strcmp(sample.name, name) == 0)
+      durations.push_back(sample.duration / 1000.0);
+
+  ProfileStatistics statistics;
+  if (durations.empty())
+    return statistics;
+  std::sort(durations.begin(), durations.end());
+  statistics.count = durations.size();
+  statistics.p50 = percentile(durations, 50);
+  statistics.p95 = percentile(durations, 95);
+  statistics.p99 = percentile(durations, 99);
+  return statistics;
+}
+
+bool Profiler::writeTrace(const std::string& path) const {
+  std::ofstream out(path.c_str());
+  if (!out.is_open()) {
+    std::cout << "INFO: Unable to write the trace to " << path << std::endl;
+    return false;
+  }
+  std::vector<ProfileSample> samples;
+  collect(samples);
+
+  // Complete ("X") events, with timestamps and durations in microseconds.
+  out << "{\"traceEvents\":[";
+  for (unsigned i = 0; i < samples.size(); i++) {
+    out << (i ? ",\n" : "\n") << "{\"name\":";
+    writeString(out, samples[i].name);
+    out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << samples[i].thread
+        << ",\"ts\":" << samples[i].start << ",\"dur\":" << samples[i].duration << "}";
+  }
+  out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  std::cout << "INFO: Wrote " << samples.size() << " trace events to " << path << std::endl;
+  return true;
+}
+
+}
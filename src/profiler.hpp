@@ -0,0 +1,99 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Sokoban {
+  /// A timed scope: what ran, on which thread, when it started and how long it took (in microseconds).
+  struct ProfileSample {
+    const char* name;
+    unsigned thread;
+    uint64_t start;
+    uint64_t duration;
+  };
+
+  /// Percentiles of the latest durations of a scope (in milliseconds).
+  struct ProfileStatistics {
+    unsigned count = 0;
+    double p50 = 0;
+    double p95 = 0;
+    double p99 = 0;
+  };
+
+  /**
+  Collects timed scopes from every thread into a fixed size ring buffer.
+
+  Recording is lock-free and never allocates: a writer claims the next slot
+  with an atomic increment and publishes it with a sequence number, so a
+  reader can tell complete samples from ones still being written. Once the
+  ring is full the oldest samples are overwritten.
+  */
+  class Profiler {
+    public:
+      /// Number of samples kept.
+      static const unsigned CAPACITY = 1 << 14;
+
+      /// The profiler shared by the whole process.
+      static Profiler& instance();
+
+      /// Microseconds since the profiler was created.
+      uint64_t now() const;
+
+      /// Record that @name ran for @duration microseconds from @start, on the calling thread.
+      void record(const char* name, uint64_t start, uint64_t duration);
+
+      /// Copy the samples still in the ring to @samples, oldest first.
+      void collect(std::vector<ProfileSample>& samples) const;
+
+      /// Percentiles of the latest (up to @count) samples named @name.
+      ProfileStatistics statistics(const char* name, unsigned count) const;
+
+      /// Write the samples still in the ring to @path, in the Chrome trace_event JSON format.
+      bool writeTrace(const std::string& path) const;
+
+    private:
+      Profiler();
+      Profiler(const Profiler&);
+      Profiler& operator=(const Profiler&);
+
+      /// A ring slot. @sequence is the claim number + 1 once the sample is complete, 0 while it is written.
+      struct Slot {
+        std::atomic<uint64_t> sequence;
+        std::atomic<const char*> name;
+        std::atomic<unsigned> thread;
+        std::atomic<uint64_t> start;
+        std::atomic<uint64_t> duration;
+      };
+
+      /// Read the sample claimed as @index into @sample. Returns false if it was overwritten or is incomplete.
+      bool read(uint64_t index, ProfileSample& sample) const;
+
+      std::chrono::steady_clock::time_point epoch;
+      std::atomic<uint64_t> head;
+      Slot slots[CAPACITY];
+  };
+
+  /// Records the time between its construction and its destruction as @name.
+  class ScopedTimer {
+    public:
+      explicit ScopedTimer(const char* name) : name(name), start(Profiler::instance().now()) {}
+
+      ~ScopedTimer() {
+        Profiler& profiler = Profiler::instance();
+        profiler.record(name, start, profiler.now() - start);
+      }
+
+    private:
+      ScopedTimer(const ScopedTimer&);
+      ScopedTimer& operator=(const ScopedTimer&);
+
+      const char* name;
+      uint64_t start;
+  };
+}
+
+#endif // _PROFILER_H_
@@ -0,0 +1,51 @@
+#ifndef _RENDERER_H_
+#define _RENDERER_H_
+
+#include <memory>
+#include <string>
+#include "simulation.hpp"
+
+namespace Sokoban {
+  /// Text drawn over the board: the status bar and, unless empty, the profiler line at the top.
+  struct HudText {
+    std::string statusbar;
+    std::string profiler;
+  };
+
+  /// The available renderers.
+  typedef enum RendererType {
+    /// 3D, with OpenGL (see SceneRenderer).
+    RENDERER_3D = 0,
+    /// 2D top-down, with an SDL_Renderer (see SpriteRenderer).
+    RENDERER_2D = 1
+  } RendererType;
+
+  /**
+  Draws the board snapshots published by the simulation, and the HUD over them.
+  Game decides what to draw and when; a renderer only decides how.
+  */
+  class Renderer {
+    public:
+      virtual ~Renderer() {}
+
+      /// Draw @snapshot and @hud, then present the frame.
+      virtual void render(const BoardSnapshot& snapshot, const HudText& hud) = 0;
+
+      /// Build ahead what drawing the level @layout needs (eg. the next one), so that switching to it is instant.
+      virtual void prepare(const std::shared_ptr<const SokoBoard>& layout) = 0;
+
+      /// Draw the image at @path over the whole window, then present it.
+      virtual void renderImage(const char* path) = 0;
+
+      /// The window is now @width x @height.
+      virtual void resize(int width, int height) = 0;
+
+      /// The mouse was dragged by @dx, @dy pixels: orbit the view, or pan it if @pan.
+      virtual void drag(double dx, double dy, bool pan) = 0;
+
+      /// Zoom in (1) or out (-1).
+      virtual void zoom(int direction) = 0;
+  };
+}
+
+#endif // _RENDERER_H_
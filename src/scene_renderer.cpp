@@ -0,0 +1,498 @@
+#include "scene_renderer.hpp"
+#include "profiler.hpp"
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_opengl.h>
+#include <iostream>
+
+namespace Sokoban {
+  const char* const SceneRenderer::targetPath[6] = {"assets/wall_top.jpg", "assets/x.png", "assets/x.png", "assets/x.png", "assets/x.png", "assets/x.png"};
+  const char* const SceneRenderer::characterPath[6] = {"assets/claudio.jpg", "assets/claudio.jpg", "assets/claudio.jpg", "assets/claudio.jpg", "assets/claudio.jpg", "assets/claudio.jpg"};
+  const char* const SceneRenderer::lightBoxPath[6] = {"assets/wood.png", "assets/wood.png", "assets/wood.png", "assets/wood.png", "assets/wood.png", "assets/wood.png"};
+  const char* const SceneRenderer::heavyBoxPath[6] = {"assets/stone.png", "assets/stone.png", "assets/stone.png", "assets/stone.png", "assets/stone.png", "assets/stone.png"};
+  const char* const SceneRenderer::wallPath[6] = {"assets/wall_top.jpg", "assets/wall_top.jpg", "assets/wall.jpg", "assets/wall.jpg", "assets/wall.jpg", "assets/wall.jpg"};
+  const char* const SceneRenderer::floorPath[6] = {"assets/wall_top.jpg", "assets/floor.jpg", "assets/wall.jpg", "assets/wall.jpg", "assets/wall.jpg", "assets/wall.jpg"};
+
+  std::vector<std::string> SceneRenderer::texturePaths() {
+    std::vector<std::string> all;
+    for (auto path : {targetPath, wallPath, floorPath})
+      all.insert(all.end(), path, path + 6);
+    return all;
+  }
+
+  std::vector<std::string> SceneRenderer::atlasPaths() {
+    std::vector<std::string> all;
+    for (int i=0; i<=5; i++){
+      all.push_back(characterPath[i]);
+      all.push_back(lightBoxPath[i]);
+      all.push_back(heavyBoxPath[i]);
+    }
+    return all;
+  }
+
+  void SceneRenderer::requestTextures(AssetLoader& loader, const AssetBundle* bundle) {
+    for (const std::string& path : texturePaths())
+      if (bundle == NULL || bundle->find(path, BUNDLE_IMAGE) == NULL)
+        loader.requestImage(path);
+    if (bundle == NULL || bundle->find(TextureAtlas::bundleName(atlasPaths()), BUNDLE_IMAGE) == NULL)
+      for (const std::string& path : atlasPaths())
+        loader.requestImage(path);
+  }
+
+  SceneRenderer::SceneRenderer(SDL_Window* window, int screenWidth, int screenHeight, TTF_Font* windowFont, SDL_Renderer* windowRenderer, AssetLoader* loader, const AssetBundle* bundle, RenderPath renderPath) :
+    window(window),
+    screenWidth(screenWidth),
+    screenHeight(screenHeight),
+    windowFont(windowFont),
+    windowRenderer(windowRenderer),
+    renderPath(renderPath),
+    levelMesh(new LevelMesh()),
+    nextLevelMesh(new LevelMesh()) {
+
+      /* Enable Z-Depth. */
+      glEnable(GL_DEPTH_TEST);
+
+      /* On the shader path lighting, tinting and texturing all happen in the shaders. */
+      if (this->renderPath == RENDER_PATH_SHADERS && !sceneShaders.build()) {
+        std::cout << "INFO: Unable to build the shaders, using the fixed-function pipeline" << std::endl;
+        this->renderPath = RENDER_PATH_FIXED;
+      }
+      if (this->renderPath == RENDER_PATH_FIXED)
+        setupFixedFunction();
+      levelMesh->setRenderPath(this->renderPath);
+      nextLevelMesh->setRenderPath(this->renderPath);
+      objectBatch.setRenderPath(this->renderPath);
+
+      /* Generating Textures: every distinct image is decoded and uploaded once. */
+      std::vector<std::string> decodedPaths = texturePaths(), objectPaths = atlasPaths();
+      decodedPaths.insert(decodedPaths.end(), objectPaths.begin(), objectPaths.end());
+      if (loader != NULL) {
+        for (const std::string& path : decodedPaths) {
+          Image image;
+          if (loader->takeImage(path, image))
+            textureCache.insert(path, image);
+        }
+      }
+      textureCache.setBundle(bundle);
+
+      for (int i=0; i<=5; i++){
+        textureTargetIDs[i] = textureCache.get(targetPath[i]);
+        textureWallIDs[i] = textureCache.get(wallPath[i]);
+        textureFloorIDs[i] = textureCache.get(floorPath[i]);
+      }
+
+      /* Dynamic objects are all drawn from a single atlas. */
+      std::vector<MipLevel> atlasLevels;
+      if (bundle == NULL || !bundle->getImage(TextureAtlas::bundleName(objectPaths), atlasLevels) ||
+          !textureAtlas.build(atlasLevels, objectPaths))
+        textureAtlas.build(textureCache, objectPaths);
+      AtlasRegion characterRegions[6], lightBoxRegions[6], heavyBoxRegions[6];
+      for (int i=0; i<=5; i++){
+        characterRegions[i] = textureAtlas.getRegion(characterPath[i]);
+        lightBoxRegions[i] = textureAtlas.getRegion(lightBoxPath[i]);
+        heavyBoxRegions[i] = textureAtlas.getRegion(heavyBoxPath[i]);
+      }
+      objectBatch.setSkin(SokoObject::CHARACTER, characterRegions);
+      objectBatch.setSkin(SokoObject::LIGHT_BOX, lightBoxRegions);
+      objectBatch.setSkin(SokoObject::HEAVY_BOX, heavyBoxRegions);
+      if (this->renderPath == RENDER_PATH_SHADERS)
+        sceneShaders.setObjectSkins(objectBatch.getSkinTable(), OBJECT_SIZE);
+      textureCache.releaseImages();
+
+      /* Rasterize the HUD font once, unless it is prerendered in the bundle. */
+      if (windowFont != NULL &&
+          (bundle == NULL || !glyphAtlas.build(*bundle, GlyphAtlas::bundleName(windowFont))) &&
+          !glyphAtlas.build(windowFont)) {
+        std::cout << "INFO: Unable to build the HUD glyph atlas: " << TTF_GetError() << std::endl;
+      }
+
+      reshape();
+    }
+
+  void SceneRenderer::setupFixedFunction() {
+    /* Normalizes the normal vectors of every vertex (ie. size = 1) */
+    glEnable(GL_NORMALIZE);
+
+    /* Shading model is smooth. */
+    glShadeModel(GL_SMOOTH);
+
+    /* Enable Lighting. */
+    glEnable(GL_LIGHTING);
+
+    /* Global ambient illumination. */
+    GLfloat globalAmbientIntensity[4] = {1.5, 1.5, 1.5, 1.0};
+    glLightModelfv(GL_LIGHT_MODEL_AMBIENT, globalAmbientIntensity);
+
+    /* LIGHT0 .*/
+    glEnable(GL_LIGHT0);
+    GLfloat light0Intensity[4] = {0.0, 1.0, 0.0, 1.0};
+    glLightfv(GL_LIGHT0, GL_DIFFUSE,  light0Intensity);
+    glLightfv(GL_LIGHT0, GL_SPECULAR, light0Intensity);
+    GLfloat light0Position[4] = {1.0, 1.0, 0.0, 0.0};
+    glLightfv(GL_LIGHT0, GL_POSITION, light0Position);
+    glLightf(GL_LIGHT0, GL_CONSTANT_ATTENUATION, 0.0);
+    glLightf(GL_LIGHT0, GL_LINEAR_ATTENUATION, 0.0); 
+    glLightf(GL_LIGHT0, GL_QUADRATIC_ATTENUATION, 0.1);
+
+    /* LIGHT1 .*/
+    glEnable(GL_LIGHT1);
+    GLfloat light1Intensity[4] = {1.0, 0, 0, 1.0};
+    glLightfv(GL_LIGHT1, GL_DIFFUSE,  light1Intensity);
+    glLightfv(GL_LIGHT1, GL_SPECULAR, light1Intensity);
+    GLfloat light1Position[4] = {1.0, 0.0, 1.0, 0.0};
+    glLightfv(GL_LIGHT1, GL_POSITION, light1Position);
+    glLightf(GL_LIGHT1, GL_CONSTANT_ATTENUATION, 0.0); 
+    glLightf(GL_LIGHT1, GL_LINEAR_ATTENUATION, 0.0); 
+    glLightf(GL_LIGHT1, GL_QUADRATIC_ATTENUATION, 0.1);
+
+    /* LIGHT2. */
+    glEnable(GL_LIGHT2);
+    GLfloat light2Intensity[4] = {1.0, 1.0, 0.0, 1.0};
+    glLightfv(GL_LIGHT2, GL_DIFFUSE, light2Intensity);
+    glLightfv(GL_LIGHT2, GL_SPECULAR, light2Intensity);
+    GLfloat light2Position[4] = {0.0, 1.0, 1.0, 0.0};
+    glLightfv(GL_LIGHT2, GL_POSITION, light2Position);
+    glLightf(GL_LIGHT2, GL_CONSTANT_ATTENUATION, 0.0);
+    glLightf(GL_LIGHT2, GL_LINEAR_ATTENUATION, 0.0); 
+    glLightf(GL_LIGHT2, GL_QUADRATIC_ATTENUATION, 0.1);
+
+    /* Texturing. */
+    glEnable(GL_TEXTURE_2D);
+    glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+    /* Set the Projection Matrix to the Identity. */
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+  }
+
+  void SceneRenderer::render(const BoardSnapshot& snapshot, const HudText& hud) {
+    updateLevelMesh(snapshot);
+
+    // Clear.
+    glClearColor(230/255.0, 212/255.0, 143/255.0, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Camera: the input received since the last frame is applied once, here.
+    camera.update();
+
+    // Dynamic objects: all of them in one batch, refreshed only when the board changed or they move.
+    if (snapshot.changes != objectChanges || snapshot.animating || objectsAnimating) {
+      objectChanges = snapshot.changes;
+      objectsAnimating = snapshot.animating;
+      ScopedTimer timer("ObjectBatch::update");
+      objectInstances.clear();
+      for (const ObjectSnapshot& obj : snapshot.objects) {
+        ObjectInstance instance = {
+          {GLfloat(obj.y * OBJECT_SIZE), GLfloat(obj.x * OBJECT_SIZE), OBJECT_SIZE},
+          obj.type, obj.onTarget
+        };
+        objectInstances.push_back(instance);
+      }
+      objectBatch.update(objectInstances, OBJECT_SIZE);
+    }
+
+    if (renderPath == RENDER_PATH_SHADERS)
+      renderShaders();
+    else
+      renderFixedFunction();
+
+    // HUD: text and quads are only laid out again when the text changes.
+    {
+      ScopedTimer timer("SceneRenderer::renderHud");
+      layoutTextBar(statusbar, hud.statusbar, SDL_Color{255, 255, 255, 255});
+      renderTextBar(statusbar, 0);
+      if (!hud.profiler.empty()) {
+        layoutTextBar(profilerBar, hud.profiler, SDL_Color{255, 255, 0, 255});
+        renderTextBar(profilerBar, screenHeight - screenHeight/20);
+      }
+    }
+
+    {
+      ScopedTimer timer("SDL_GL_SwapWindow");
+      glFlush();
+      if (window != NULL)
+        SDL_GL_SwapWindow(window);
+    }
+  }
+
+  void SceneRenderer::renderFixedFunction() {
+    glMatrixMode(GL_MODELVIEW);
+    glLoadMatrixd(camera.getViewMatrix());
+
+    // Drawing static objects
+    GLfloat white[4] = {1.0, 1.0, 1.0, 1.0};
+    setMaterial(white);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    {
+      ScopedTimer timer("LevelMesh::draw");
+      levelMesh->draw(&camera.getFrustum());
+    }
+
+    // Boxes on targets are tinted red through the vertex color.
+    glDisable(GL_LIGHTING);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glBindTexture(GL_TEXTURE_2D, textureAtlas.getTexture());
+    {
+      ScopedTimer timer("ObjectBatch::draw");
+      objectBatch.draw();
+    }
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    glEnable(GL_LIGHTING);
+  }
+
+  void SceneRenderer::renderShaders() {
+    // Matrices and lights are uploaded once for the whole frame.
+    sceneShaders.beginFrame(camera.getProjectionMatrix(), camera.getViewMatrix());
+
+    // Both meshes wind their faces counterclockwise from outside: back faces are never seen.
+    glEnable(GL_CULL_FACE);
+
+    // Objects first: they hide floor the depth test then rejects before shading it.
+    {
+      ScopedTimer timer("ObjectBatch::draw");
+      sceneShaders.useObjects();
+      glBindTexture(GL_TEXTURE_2D, textureAtlas.getTexture());
+      objectBatch.draw();
+    }
+
+    {
+      ScopedTimer timer("LevelMesh::draw");
+      sceneShaders.useMesh();
+      levelMesh->draw(&camera.getFrustum());
+    }
+
+    glUseProgram(0);
+    glDisable(GL_CULL_FACE);
+  }
+
+  void SceneRenderer::layoutTextBar(TextBar& bar, const std::string& text, SDL_Color color) {
+    if (!bar.vertices.empty() && bar.text == text)
+      return;
+    bar.text = text;
+    bar.color = color;
+    bar.vertices.clear();
+    bar.width = glyphAtlas.layout(text, bar.vertices);
+    bar.triangles.clear();
+    if (renderPath == RENDER_PATH_SHADERS)
+      quadsToTriangles(bar.vertices, bar.triangles);
+  }
+
+  void SceneRenderer::renderTextBar(const TextBar& bar, int y) {
+    // Text is laid out in pixels (y down) and stretched over the whole bar.
+    GLfloat width = bar.width > 0 ? bar.width : 1;
+    GLfloat height = glyphAtlas.getHeight() > 0 ? glyphAtlas.getHeight() : 1;
+
+    if (renderPath == RENDER_PATH_SHADERS) {
+      glDisable(GL_DEPTH_TEST);
+      glViewport(0, y, screenWidth, screenHeight/20);
+
+      // Background, then the text from the glyph atlas.
+      const TextVertex corners[4] = {{{0, 0}, {0, 0}}, {{width, 0}, {0, 0}}, {{width, height}, {0, 0}}, {{0, height}, {0, 0}}};
+      std::vector<TextVertex> background;
+      quadsToTriangles(std::vector<TextVertex>(corners, corners + 4), background);
+      const GLfloat black[4] = {0, 0, 0, 1};
+      sceneShaders.drawOverlay(background, 0, black, width, height);
+
+      glEnable(GL_BLEND);
+      glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+      const GLfloat color[4] = {bar.color.r / 255.0f, bar.color.g / 255.0f,
+                                bar.color.b / 255.0f, bar.color.a / 255.0f};
+      sceneShaders.drawOverlay(bar.triangles, glyphAtlas.getTexture(), color, width, height);
+      glDisable(GL_BLEND);
+      glUseProgram(0);
+
+      glEnable(GL_DEPTH_TEST);
+      glViewport(0, 0, screenWidth, screenHeight);
+      return;
+    }
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix(); 
+    glLoadIdentity();
+    glOrtho(0, width, height, 0, -1, 1);
+
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    // Disabling depth test and lighting for 2d rendering
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_LIGHTING);
+
+    // Setting the viewport
+    glViewport(0, y, screenWidth, screenHeight/20);
+
+    // Background
+    glDisable(GL_TEXTURE_2D);
+    glColor4ub(0, 0, 0, 255);
+    glRectf(0, 0, width, height);
+    glEnable(GL_TEXTURE_2D);
+
+    // Text, from the glyph atlas
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glColor4ub(bar.color.r, bar.color.g, bar.color.b, bar.color.a);
+    glBindTexture(GL_TEXTURE_2D, glyphAtlas.getTexture());
+    if (!bar.vertices.empty()) {
+      glEnableClientState(GL_VERTEX_ARRAY);
+      glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+      glVertexPointer(2, GL_FLOAT, sizeof(TextVertex), &bar.vertices[0].position);
+      glTexCoordPointer(2, GL_FLOAT, sizeof(TextVertex), &bar.vertices[0].texCoord);
+      glDrawArrays(GL_QUADS, 0, bar.vertices.size());
+      glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+      glDisableClientState(GL_VERTEX_ARRAY);
+    }
+
+    // Cleaning the used state
+    glColor4ub(255, 255, 255, 255);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    glDisable(GL_BLEND);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_DEPTH_TEST);
+    glViewport(0, 0, screenWidth, screenHeight);
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();    
+    glMatrixMode(GL_MODELVIEW);
+  }
+
+  void SceneRenderer::setMaterial(const GLfloat* color) {
+    GLfloat white[4] = {1.0, 1.0, 1.0, 1.0};
+    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, color);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, white);
+    glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, 100.0);
+  }
+
+  void SceneRenderer::drag(double dx, double dy, bool pan) {
+    if (pan)
+      camera.pan(dx, dy);
+    else
+      camera.orbit(dx, dy);
+  }
+
+  void SceneRenderer::zoom(int direction) {
+    camera.zoom(direction);
+  }
+
+  void SceneRenderer::reshape() {
+    glViewport(0.0, 0.0, screenWidth, screenHeight);
+    camera.setPerspective(65.0, GLdouble(screenWidth)/screenHeight, 1.0, 10.0);
+    if (renderPath == RENDER_PATH_FIXED) {
+      glMatrixMode(GL_PROJECTION);
+      glLoadMatrixd(camera.getProjectionMatrix());
+      glMatrixMode(GL_MODELVIEW);
+    }
+  }
+
+  void SceneRenderer::resize(int width, int height) {
+    this->screenWidth = width;
+    this->screenHeight = height;
+    reshape();
+  }
+
+  void SceneRenderer::updateLevelMesh(const BoardSnapshot& snapshot) {
+    if (!snapshot.layout || snapshot.layout == meshLayout)
+      return;
+    meshLayout = snapshot.layout;
+    unsigned rebuilt = 0;
+    if (meshLayout == nextMeshLayout) {
+      std::swap(levelMesh, nextLevelMesh);
+      nextMeshLayout.reset();
+    }
+    else
+      rebuilt = levelMesh->build(*meshLayout, textureFloorIDs, textureWallIDs, textureTargetIDs);
+    SDL_Log("Level %d: %u static quads in %u chunks (%u rebuilt), %u draw calls", snapshot.level,
+            levelMesh->getNumberOfQuads(), levelMesh->getNumberOfChunks(), rebuilt,
+            levelMesh->getNumberOfBatches());
+  }
+
+  void SceneRenderer::prepare(const std::shared_ptr<const SokoBoard>& layout) {
+    if (!layout || layout == meshLayout || layout == nextMeshLayout)
+      return;
+    ScopedTimer timer("SceneRenderer::prepare");
+    nextMeshLayout = layout;
+    nextLevelMesh->build(*layout, textureFloorIDs, textureWallIDs, textureTargetIDs);
+  }
+
+  void SceneRenderer::renderImage(const char* path) {
+    if (renderPath == RENDER_PATH_SHADERS) {
+      // No SDL renderer textures on a core context: upload the image and draw it over the window.
+      Image image;
+      if (!loadImage(path, image))
+        return;
+      GLuint texture;
+      glGenTextures(1, &texture);
+      glBindTexture(GL_TEXTURE_2D, texture);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      MipLevel level;
+      level.width = image.width;
+      level.height = image.height;
+      level.pixels = image.pixels.data();
+      uploadMipmaps(std::vector<MipLevel>(1, level));
+
+      const TextVertex corners[4] = {{{0, 0}, {0, 0}}, {{1, 0}, {1, 0}}, {{1, 1}, {1, 1}}, {{0, 1}, {0, 1}}};
+      std::vector<TextVertex> triangles;
+      quadsToTriangles(std::vector<TextVertex>(corners, corners + 4), triangles);
+      const GLfloat white[4] = {1, 1, 1, 1};
+      glDisable(GL_DEPTH_TEST);
+      sceneShaders.drawOverlay(triangles, texture, white, 1, 1);
+      glUseProgram(0);
+      glEnable(GL_DEPTH_TEST);
+
+      glFlush();
+      if (window != NULL)
+        SDL_GL_SwapWindow(window);
+      glDeleteTextures(1, &texture);
+      return;
+    }
+
+    SDL_Surface* loadedSurface = IMG_Load(path);
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(windowRenderer, loadedSurface);    
+    
+    // Starting the matrixes.
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix(); 
+    glLoadIdentity();
+
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    glDisable(GL_DEPTH_TEST);
+
+    float width, height;
+    float x = -1.0, y = -1.0;
+    SDL_GL_BindTexture(texture, &width, &height);
+
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.0, 1.0 * height);         glVertex2f(x, y);
+    glTexCoord2f(1.0 * width, 1.0 * height); glVertex2f(x + 2.0, y);
+    glTexCoord2f(1.0 * width, 0.0);          glVertex2f(x + 2.0, y + 2.0);
+    glTexCoord2f(0.0, 0.0);                  glVertex2f(x, y + 2.0);
+    glEnd();
+
+    // Popping the matrixes
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+
+    glFlush();
+    if (window != NULL)
+      SDL_GL_SwapWindow(window);
+
+    SDL_GL_UnbindTexture(texture);
+    SDL_DestroyTexture(texture);
+    SDL_FreeSurface(loadedSurface);
+  }
+
+  Camera& SceneRenderer::getCamera() {
+    return camera;
+  }
+}
@@ -0,0 +1,163 @@
+#ifndef _SCENE_RENDERER_H_
+#define _SCENE_RENDERER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include "asset_bundle.hpp"
+#include "asset_loader.hpp"
+#include "camera.hpp"
+#include "glyph_atlas.hpp"
+#include "level_mesh.hpp"
+#include "object_batch.hpp"
+#include "renderer.hpp"
+#include "scene_shaders.hpp"
+#include "texture_atlas.hpp"
+#include "texture_cache.hpp"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+namespace Sokoban {
+  /**
+  The 3D renderer: the board as textured cubes with OpenGL, orbited by a
+  camera, through the shaders or the fixed-function pipeline.
+  */
+  class SceneRenderer : public Renderer {
+    public:
+      /// Set up OpenGL and the textures. Textures in @bundle are uploaded from it, images already decoded by @loader are taken from it.
+      /// RENDER_PATH_SHADERS needs a 3.3 core profile context; it falls back to the fixed path if the shaders do not build.
+      /// Without a window (offscreen rendering) frames are not swapped; without a font the HUD has no text.
+      SceneRenderer(SDL_Window*, int screenWidth, int screenHeight, TTF_Font* windowFont,
+                    SDL_Renderer* windowRenderer, AssetLoader* loader = NULL,
+                    const AssetBundle* bundle = NULL, RenderPath renderPath = RENDER_PATH_FIXED);
+
+      /// Queue the decoding of every texture missing from @bundle on @loader, ahead of the construction.
+      static void requestTextures(AssetLoader& loader, const AssetBundle* bundle = NULL);
+
+      void render(const BoardSnapshot& snapshot, const HudText& hud);
+      void prepare(const std::shared_ptr<const SokoBoard>& layout);
+      void renderImage(const char* path);
+      void resize(int width, int height);
+      void drag(double dx, double dy, bool pan);
+      void zoom(int direction);
+
+      /// Get the camera, eg. to save or restore the view.
+      Camera& getCamera();
+
+    private:
+      /// Image paths of the static geometry textures (with repetitions).
+      static std::vector<std::string> texturePaths();
+
+      /// Image paths packed in the atlas of the dynamic objects (with repetitions).
+      static std::vector<std::string> atlasPaths();
+
+      /// A line of text stretched over a strip of the window: its text, color, quads and width (in pixels).
+      struct TextBar {
+        std::string text;
+        SDL_Color color;
+        std::vector<TextVertex> vertices;
+        std::vector<TextVertex> triangles;
+        int width = 0;
+      };
+
+      /// Lay @text out in @bar with the glyph atlas, unless it already holds it.
+      void layoutTextBar(TextBar& bar, const std::string& text, SDL_Color color);
+
+      /// Render @bar over the strip of the window @y pixels above its bottom.
+      void renderTextBar(const TextBar& bar, int y);
+
+      /// Set up the fixed-function lights and texturing.
+      void setupFixedFunction();
+
+      /// Set the material of the next drawn faces, with @color as ambient and diffuse.
+      void setMaterial(const GLfloat* color);
+
+      /// Draw the static mesh and the objects with the fixed-function pipeline.
+      void renderFixedFunction();
+
+      /// Draw the static mesh and the objects with the shaders.
+      void renderShaders();
+
+      /// Switch to the mesh of the level of @snapshot if it is newly loaded: the one prepared ahead, or a rebuilt one.
+      void updateLevelMesh(const BoardSnapshot& snapshot);
+
+      /// Set the viewport and the projection to the window size.
+      void reshape();
+
+      /// Main SDL window.
+      SDL_Window* window;
+
+      int screenWidth, screenHeight;
+
+      /// The window font (TTF).
+      TTF_Font* windowFont;
+
+      /// The main window renderer.
+      SDL_Renderer* windowRenderer;
+
+      /// Layout the level mesh was last built from.
+      std::shared_ptr<const SokoBoard> meshLayout;
+
+      /// Fixed-function or shader pipeline.
+      RenderPath renderPath;
+
+      /// Shaders of the shader path.
+      SceneShaders sceneShaders;
+
+      /// Textures of the static geometry, one per distinct image.
+      TextureCache textureCache;
+
+      /// Atlas with the images of the dynamic objects.
+      TextureAtlas textureAtlas;
+
+      /// Static geometry of the current board, rebuilt when a level is loaded.
+      std::unique_ptr<LevelMesh> levelMesh;
+
+      /// Static geometry prepared ahead for the board in @nextMeshLayout, swapped in when it is loaded.
+      std::unique_ptr<LevelMesh> nextLevelMesh;
+      std::shared_ptr<const SokoBoard> nextMeshLayout;
+
+      /// Dynamic objects of the current frame.
+      std::vector<ObjectInstance> objectInstances;
+
+      /// Draws all the dynamic objects at once.
+      ObjectBatch objectBatch;
+
+      /// Board changes the batch was last updated for, and whether its objects were still moving.
+      unsigned objectChanges = ~0u;
+      bool objectsAnimating = false;
+
+      /// Glyphs of the window font, for the HUD.
+      GlyphAtlas glyphAtlas;
+
+      /// Current status bar.
+      TextBar statusbar;
+
+      /// Frame time percentiles, shown over the top of the window when enabled.
+      TextBar profilerBar;
+
+      /// The camera: orbit, pan and zoom (the game scale).
+      Camera camera;
+
+      /// Edge of the cubes of the dynamic objects.
+      const GLfloat OBJECT_SIZE = 0.5;
+
+      static const char* const targetPath[6];
+      GLuint textureTargetIDs[6];
+
+      static const char* const characterPath[6];
+
+      static const char* const lightBoxPath[6];
+
+      static const char* const heavyBoxPath[6];
+
+      static const char* const wallPath[6];
+      GLuint textureWallIDs[6];
+
+      static const char* const floorPath[6];
+      GLuint textureFloorIDs[6];
+  };
+}
+
+#endif // _SCENE_RENDERER_H_
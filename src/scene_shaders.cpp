@@ -0,0 +1,208 @@
+#include "scene_shaders.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+namespace Sokoban {
+
+namespace {
+  const char* const VERSION = "#version 330 core\n";
+
+  /// Per vertex lighting, as set up for the fixed-function pipeline: a white
+  /// material (shininess 100) under the global ambient and three directional
+  /// lights with an infinite viewer. Light directions are in eye space.
+  const char* const LIGHTING =
+    "uniform mat4 uProjection;\n"
+    "uniform mat4 uView;\n"
+    "uniform vec3 uAmbient;\n"
+    "uniform vec3 uLightDirections[3];\n"
+    "uniform vec3 uLightColors[3];\n"
+    "vec3 lighting(vec3 normal) {\n"
+    "  vec3 n = normalize(mat3(uView) * normal);\n"
+    "  vec3 color = uAmbient;\n"
+    "  for (int i = 0; i < 3; i++) {\n"
+    "    float diffuse = dot(n, uLightDirections[i]);\n"
+    "    if (diffuse > 0.0) {\n"
+    "      vec3 h = normalize(uLightDirections[i] + vec3(0.0, 0.0, 1.0));\n"
+    "      color += uLightColors[i] * (diffuse + pow(max(dot(n, h), 0.0), 100.0));\n"
+    "    }\n"
+    "  }\n"
+    "  return min(color, vec3(1.0));\n"
+    "}\n";
+
+  const char* const MESH_VERTEX =
+    "layout(location = 0) in vec3 aPosition;\n"
+    "layout(location = 1) in vec3 aNormal;\n"
+    "layout(location = 2) in vec2 aTexCoord;\n"
+    "out vec2 vTexCoord;\n"
+    "out vec4 vColor;\n"
+    "void main() {\n"
+    "  gl_Position = uProjection * uView * vec4(aPosition, 1.0);\n"
+    "  vTexCoord = aTexCoord;\n"
+    "  vColor = vec4(lighting(aNormal), 1.0);\n"
+    "}\n";
+
+  const char* const OBJECTS_VERTEX =
+    "layout(location = 0) in vec3 aCorner;\n"
+    "layout(location = 1) in vec3 aNormal;\n"
+    "layout(location = 2) in vec2 aTexCoord;\n"
+    "layout(location = 3) in float aFace;\n"
+    "layout(location = 4) in vec3 aInstancePosition;\n"
+    "layout(location = 5) in float aInstanceSkin;\n"
+    "layout(location = 6) in vec4 aInstanceTint;\n"
+    "uniform vec4 uRegions[24];\n"
+    "uniform float uHalfEdge;\n"
+    "out vec2 vTexCoord;\n"
+    "out vec4 vColor;\n"
+    "void main() {\n"
+    "  gl_Position = uProjection * uView * vec4(aInstancePosition + uHalfEdge * aCorner, 1.0);\n"
+    "  vec4 region = uRegions[int(aInstanceSkin) * 6 + int(aFace)];\n"
+    "  vTexCoord = mix(region.xy, region.zw, aTexCoord);\n"
+    "  vColor = vec4(lighting(aNormal), 1.0) * aInstanceTint;\n"
+    "}\n";
+
+  const char* const SCENE_FRAGMENT =
+    "in vec2 vTexCoord;\n"
+    "in vec4 vColor;\n"
+    "uniform sampler2D uTexture;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "  fragColor = texture(uTexture, vTexCoord) * vColor;\n"
+    "}\n";
+
+  const char* const OVERLAY_VERTEX =
+    "layout(location = 0) in vec2 aPosition;\n"
+    "layout(location = 2) in vec2 aTexCoord;\n"
+    "uniform mat4 uProjection;\n"
+    "out vec2 vTexCoord;\n"
+    "void main() {\n"
+    "  gl_Position = uProjection * vec4(aPosition, 0.0, 1.0);\n"
+    "  vTexCoord = aTexCoord;\n"
+    "}\n";
+
+  const char* const OVERLAY_FRAGMENT =
+    "in vec2 vTexCoord;\n"
+    "uniform sampler2D uTexture;\n"
+    "uniform bool uTextured;\n"
+    "uniform vec4 uColor;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "  fragColor = uTextured ? texture(uTexture, vTexCoord) * uColor : uColor;\n"
+    "}\n";
+
+  /// The fixed-function lights of Game: global ambient, then the directions (towards the light) and colors.
+  const GLfloat AMBIENT[3] = {1.5, 1.5, 1.5};
+  const GLfloat LIGHT_DIRECTIONS[3][3] = {
+    {0.70710678f, 0.70710678f, 0.0f}, {0.70710678f, 0.0f, 0.70710678f}, {0.0f, 0.70710678f, 0.70710678f}
+  };
+  const GLfloat LIGHT_COLORS[3][3] = {{0.0, 1.0, 0.0}, {1.0, 0.0, 0.0}, {1.0, 1.0, 0.0}};
+}
+
+void quadsToTriangles(const std::vector<TextVertex>& quads, std::vector<TextVertex>& triangles) {
+  for (unsigned i = 0; i + 3 < quads.size(); i += 4) {
+    const unsigned corners[6] = {0, 1, 2, 0, 2, 3};
+    for (unsigned corner : corners)
+      triangles.push_back(quads[i + corner]);
+  }
+}
+
+SceneShaders::SceneShaders() {}
+
+SceneShaders::~SceneShaders() {
+  if (overlayVbo != 0)
+    glDeleteBuffers(1, &overlayVbo);
+  if (overlayVao != 0)
+    glDeleteVertexArrays(1, &overlayVao);
+}
+
+bool SceneShaders::build() {
+  if (!mesh.build(std::string(VERSION) + LIGHTING + MESH_VERTEX, std::string(VERSION) + SCENE_FRAGMENT) ||
+      !objects.build(std::string(VERSION) + LIGHTING + OBJECTS_VERTEX, std::string(VERSION) + SCENE_FRAGMENT) ||
+      !overlay.build(std::string(VERSION) + OVERLAY_VERTEX, std::string(VERSION) + OVERLAY_FRAGMENT))
+    return false;
+
+  for (const ShaderProgram* program : {&mesh, &objects, &overlay}) {
+    program->use();
+    glUniform1i(program->uniform("uTexture"), 0);
+  }
+
+  if (overlayVao == 0) {
+    glGenVertexArrays(1, &overlayVao);
+    glGenBuffers(1, &overlayVbo);
+    glBindVertexArray(overlayVao);
+    glBindBuffer(GL_ARRAY_BUFFER, overlayVbo);
+    glEnableVertexAttribArray(ATTRIBUTE_POSITION);
+    glEnableVertexAttribArray(ATTRIBUTE_TEX_COORD);
+    glVertexAttribPointer(ATTRIBUTE_POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex),
+                          (const GLvoid*) offsetof(TextVertex, position));
+    glVertexAttribPointer(ATTRIBUTE_TEX_COORD, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex),
+                          (const GLvoid*) offsetof(TextVertex, texCoord));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+  glUseProgram(0);
+  return true;
+}
+
+void SceneShaders::uploadFrame(const ShaderProgram& program, const GLfloat* projection, const GLfloat* view) {
+  program.use();
+  glUniformMatrix4fv(program.uniform("uProjection"), 1, GL_FALSE, projection);
+  glUniformMatrix4fv(program.uniform("uView"), 1, GL_FALSE, view);
+  glUniform3fv(program.uniform("uAmbient"), 1, AMBIENT);
+  glUniform3fv(program.uniform("uLightDirections"), 3, &LIGHT_DIRECTIONS[0][0]);
+  glUniform3fv(program.uniform("uLightColors"), 3, &LIGHT_COLORS[0][0]);
+}
+
+void SceneShaders::beginFrame(const double* projection, const double* view) {
+  GLfloat projectionMatrix[16], viewMatrix[16];
+  for (int i = 0; i < 16; i++) {
+    projectionMatrix[i] = projection[i];
+    viewMatrix[i] = view[i];
+  }
+  uploadFrame(mesh, projectionMatrix, viewMatrix);
+  uploadFrame(objects, projectionMatrix, viewMatrix);
+}
+
+void SceneShaders::setObjectSkins(const std::vector<GLfloat>& regions, GLfloat edge) {
+  objects.use();
+  GLsizei count = std::min<GLsizei>(regions.size() / 4, 6 * MAX_SKINS);
+  if (count > 0)
+    glUniform4fv(objects.uniform("uRegions"), count, regions.data());
+  glUniform1f(objects.uniform("uHalfEdge"), edge / 2);
+}
+
+void SceneShaders::useMesh() const {
+  mesh.use();
+}
+
+void SceneShaders::useObjects() const {
+  objects.use();
+}
+
+void SceneShaders::drawOverlay(const std::vector<TextVertex>& triangles, GLuint texture, const GLfloat color[4],
+                               GLfloat width, GLfloat height) {
+  if (triangles.empty())
+    return;
+
+  // Same as glOrtho(0, width, height, 0, -1, 1).
+  const GLfloat projection[16] = {
+    2 / width, 0, 0, 0,
+    0, -2 / height, 0, 0,
+    0, 0, -1, 0,
+    -1, 1, 0, 1
+  };
+  overlay.use();
+  glUniformMatrix4fv(overlay.uniform("uProjection"), 1, GL_FALSE, projection);
+  glUniform4fv(overlay.uniform("uColor"), 1, color);
+  glUniform1i(overlay.uniform("uTextured"), texture != 0);
+  glBindTexture(GL_TEXTURE_2D, texture);
+
+  glBindVertexArray(overlayVao);
+  glBindBuffer(GL_ARRAY_BUFFER, overlayVbo);
+  glBufferData(GL_ARRAY_BUFFER, triangles.size() * sizeof(TextVertex), triangles.data(), GL_STREAM_DRAW);
+  glDrawArrays(GL_TRIANGLES, 0, triangles.size());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+}
@@ -0,0 +1,83 @@
+#ifndef _SCENE_SHADERS_H_
+#define _SCENE_SHADERS_H_
+
+#include <GL/glew.h>
+#include <vector>
+#include "glyph_atlas.hpp"
+#include "shader_program.hpp"
+
+namespace Sokoban {
+  /// How the game draws: the legacy fixed-function pipeline, or GLSL 3.30 shaders on a core profile context.
+  enum RenderPath {
+    RENDER_PATH_FIXED = 0,
+    RENDER_PATH_SHADERS = 1
+  };
+
+  /// Vertex attribute locations shared by every shader of the set.
+  enum ShaderAttribute {
+    ATTRIBUTE_POSITION = 0,
+    ATTRIBUTE_NORMAL = 1,
+    ATTRIBUTE_TEX_COORD = 2,
+    ATTRIBUTE_FACE = 3,
+    ATTRIBUTE_INSTANCE_POSITION = 4,
+    ATTRIBUTE_INSTANCE_SKIN = 5,
+    ATTRIBUTE_INSTANCE_TINT = 6
+  };
+
+  /// Append the two triangles of each quad of @quads to @triangles.
+  void quadsToTriangles(const std::vector<TextVertex>& quads, std::vector<TextVertex>& triangles);
+
+  /**
+  The shaders of the core profile path: the static mesh, the instanced dynamic
+  objects and the 2D overlays (status bar, full screen images).
+
+  Lighting reproduces the fixed-function setup (global ambient plus three
+  directional lights, per vertex) and runs together with the texture lookup
+  and the on-target tint in the shaders. Matrices and lights are uploaded once
+  per frame, in beginFrame().
+  */
+  class SceneShaders {
+    public:
+      /// Most object skins the objects shader holds.
+      static const int MAX_SKINS = 4;
+
+      SceneShaders();
+
+      /// Delete the overlay buffers.
+      ~SceneShaders();
+
+      /// Compile the shaders. Needs a 3.3 core context. Returns false on failure.
+      bool build();
+
+      /// Upload the column-major @projection and @view matrices, and the lights.
+      void beginFrame(const double* projection, const double* view);
+
+      /// Set the atlas regions of the object faces (u0, v0, u1, v1 per face, six faces per skin) and the cube @edge.
+      void setObjectSkins(const std::vector<GLfloat>& regions, GLfloat edge);
+
+      /// Bind the shader of the static mesh.
+      void useMesh() const;
+
+      /// Bind the shader of the object instances.
+      void useObjects() const;
+
+      /// Draw @triangles (in pixels, y down, over a @width x @height view) with @texture, modulated by @color.
+      /// A 0 @texture draws them in plain @color.
+      void drawOverlay(const std::vector<TextVertex>& triangles, GLuint texture, const GLfloat color[4],
+            GLfloat width, GLfloat height);
+
+    private:
+      SceneShaders(const SceneShaders&);
+      SceneShaders& operator=(const SceneShaders&);
+
+      /// Upload the frame uniforms to one of the 3D programs.
+      void uploadFrame(const ShaderProgram& program, const GLfloat* projection, const GLfloat* view);
+
+      ShaderProgram mesh, objects, overlay;
+
+      /// Streaming buffer of the overlays.
+      GLuint overlayVao = 0, overlayVbo = 0;
+  };
+}
+
+#endif // _SCENE_SHADERS_H_
@@ -58,6 +58,15 @@ void Menu::renderMainMenu() {
     SDL_RenderCopy(windowRenderer, inTextures[currentIndex], NULL, &rects[currentIndex]);
   }
   SDL_RenderPresent(windowRenderer);
+  dirty = false;
+}
+
+bool Menu::isDirty() const {
+  return dirty;
+}
+
+void Menu::invalidate() {
+  dirty = true;
 }
 
 unsigned Menu::getCurrentIndex() const {
@@ -66,9 +75,11 @@ unsigned Menu::getCurrentIndex() const {
 
 void Menu::prevIndex() {
   currentIndex = (currentIndex + labels.size() - 1) % labels.size();
+  dirty = true;
 }
 
 void Menu::nextIndex() {
   currentIndex = (currentIndex + 1) % labels.size();
+  dirty = true;
 }
 
@@ -20,6 +20,12 @@ class Menu {
     
     /// Main rendering function: renderizes this menu.
     void renderMainMenu();
+
+    /// Return true if the menu changed since it was last rendered.
+    bool isDirty() const;
+
+    /// Force the next renderMainMenu() (eg. the mouse moved or the window was exposed).
+    void invalidate();
     
     /// Get current selected menu entry.
     unsigned getCurrentIndex() const;
@@ -43,6 +49,9 @@ class Menu {
     /// Current selected menu entry.
     int currentIndex = 0;
 
+    /// Set when the menu must be rendered again.
+    bool dirty = true;
+
   private:
     /// Main window renderer.
     SDL_Renderer *windowRenderer;
@@ -0,0 +1,81 @@
+#include "shader_program.hpp"
+#include <iostream>
+#include <vector>
+
+namespace Sokoban {
+
+ShaderProgram::ShaderProgram() {}
+
+ShaderProgram::~ShaderProgram() {
+  if (program != 0)
+    glDeleteProgram(program);
+}
+
+GLuint ShaderProgram::compile(GLenum type, const std::string& source) {
+  GLuint shader = glCreateShader(type);
+  const GLchar* text = source.c_str();
+  glShaderSource(shader, 1, &text, NULL);
+  glCompileShader(shader);
+
+  GLint status = GL_FALSE;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+  if (status != GL_TRUE) {
+    GLint length = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+    std::vector<GLchar> log(length + 1, '\0');
+    glGetShaderInfoLog(shader, length, NULL, log.data());
+    std::cout << "INFO: Unable to compile the " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment")
+              << " shader: " << log.data() << std::endl;
+    glDeleteShader(shader);
+    return 0;
+  }
+  return shader;
+}
+
+bool ShaderProgram::build(const std::string& vertexSource, const std::string& fragmentSource) {
+  GLuint vertex = compile(GL_VERTEX_SHADER, vertexSource);
+  GLuint fragment = compile(GL_FRAGMENT_SHADER, fragmentSource);
+  if (vertex == 0 || fragment == 0) {
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    return false;
+  }
+
+  GLuint linked = glCreateProgram();
+  glAttachShader(linked, vertex);
+  glAttachShader(linked, fragment);
+  glLinkProgram(linked);
+  glDeleteShader(vertex);
+  glDeleteShader(fragment);
+
+  GLint status = GL_FALSE;
+  glGetProgramiv(linked, GL_LINK_STATUS, &status);
+  if (status != GL_TRUE) {
+    GLint length = 0;
+    glGetProgramiv(linked, GL_INFO_LOG_LENGTH, &length);
+    std::vector<GLchar> log(length + 1, '\0');
+    glGetProgramInfoLog(linked, length, NULL, log.data());
+    std::cout << "INFO: Unable to link the shader program: " << log.data() << std::endl;
+    glDeleteProgram(linked);
+    return false;
+  }
+
+  if (program != 0)
+    glDeleteProgram(program);
+  program = linked;
+  return true;
+}
+
+void ShaderProgram::use() const {
+  glUseProgram(program);
+}
+
+GLint ShaderProgram::uniform(const char* name) const {
+  return glGetUniformLocation(program, name);
+}
+
+bool ShaderProgram::isValid() const {
+  return program != 0;
+}
+
+}
@@ -0,0 +1,39 @@
+#ifndef _SHADER_PROGRAM_H_
+#define _SHADER_PROGRAM_H_
+
+#include <GL/glew.h>
+#include <string>
+
+namespace Sokoban {
+  /// A linked GLSL program: one vertex and one fragment shader.
+  class ShaderProgram {
+    public:
+      ShaderProgram();
+
+      /// Delete the program.
+      ~ShaderProgram();
+
+      /// Compile and link @vertexSource and @fragmentSource. Returns false (and logs why) on failure.
+      bool build(const std::string& vertexSource, const std::string& fragmentSource);
+
+      /// Make this program current.
+      void use() const;
+
+      /// Location of the uniform @name, or -1 if it is not used by the program.
+      GLint uniform(const char* name) const;
+
+      /// Return true once build() succeeded.
+      bool isValid() const;
+
+    private:
+      ShaderProgram(const ShaderProgram&);
+      ShaderProgram& operator=(const ShaderProgram&);
+
+      /// Compile a shader of @type. Returns 0 (and logs why) on failure.
+      static GLuint compile(GLenum type, const std::string& source);
+
+      GLuint program = 0;
+  };
+}
+
+#endif // _SHADER_PROGRAM_H_
@@ -0,0 +1,319 @@
+#include "simulation.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace Sokoban {
+
+const double Simulation::ANIMATION_DURATION = 0.3;
+const double Simulation::TICK = 1.0 / 120;
+const unsigned Simulation::MAX_COALESCED = 4;
+
+Simulation::Simulation(bool logBoard) : logBoard(logBoard) {
+  thread = std::thread(&Simulation::run, this);
+}
+
+Simulation::~Simulation() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+    commands.clear();
+  }
+  commandAvailable.notify_one();
+  idle.notify_all();
+  thread.join();
+}
+
+void Simulation::enqueue(const Command& command) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    commands.push_back(command);
+  }
+  commandAvailable.notify_one();
+}
+
+void Simulation::loadLevel(unsigned level, const std::string& path) {
+  Command command;
+  command.type = COMMAND_LOAD;
+  command.level = level;
+  command.path = path;
+  enqueue(command);
+}
+
+void Simulation::preloadLevel(const std::string& path) {
+  Command command;
+  command.type = COMMAND_PRELOAD;
+  command.path = path;
+  enqueue(command);
+}
+
+void Simulation::move(Direction direction) {
+  Command command;
+  command.type = COMMAND_MOVE;
+  command.direction = direction;
+  enqueue(command);
+}
+
+void Simulation::press(Direction direction) {
+  Command command;
+  command.type = COMMAND_PRESS;
+  command.direction = direction;
+  enqueue(command);
+}
+
+void Simulation::release(Direction direction) {
+  Command command;
+  command.type = COMMAND_RELEASE;
+  command.direction = direction;
+  enqueue(command);
+}
+
+void Simulation::setInput(double delay, double interval, bool coalesce) {
+  Command command;
+  command.type = COMMAND_INPUT;
+  command.delay = delay;
+  command.duration = interval;
+  command.coalesce = coalesce;
+  enqueue(command);
+}
+
+void Simulation::undo() {
+  Command command;
+  command.type = COMMAND_UNDO;
+  enqueue(command);
+}
+
+void Simulation::setAnimation(double duration, Easing easing) {
+  Command command;
+  command.type = COMMAND_ANIMATION;
+  command.duration = duration;
+  command.easing = easing;
+  enqueue(command);
+}
+
+void Simulation::setPublishListener(const std::function<void()>& listener) {
+  std::lock_guard<std::mutex> lock(mutex);
+  publishListener = listener;
+}
+
+bool Simulation::hasSnapshot() const {
+  return snapshots.hasUpdate();
+}
+
+bool Simulation::acquire() {
+  return snapshots.update();
+}
+
+const BoardSnapshot& Simulation::snapshot() const {
+  return snapshots.front();
+}
+
+void Simulation::waitIdle() {
+  std::unique_lock<std::mutex> lock(mutex);
+  idle.wait(lock, [this] { return stopping || (commands.empty() && !working && !animating); });
+}
+
+void Simulation::takeEvents(std::vector<SokoEvent>& taken) {
+  taken.clear();
+  std::lock_guard<std::mutex> lock(mutex);
+  taken.swap(events);
+}
+
+void Simulation::run() {
+  typedef std::chrono::steady_clock Clock;
+  std::deque<Command> pending;
+  const Clock::time_point start = Clock::now();
+  Clock::time_point last = start;
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    // Sleep until the next command, the next tick while something moves, or the next repeat of a held key.
+    // With no board a held key is not taken (and loading one drops it): no repeat to wake up for.
+    bool ticking = !moving.empty();
+    if (ticking)
+      commandAvailable.wait_for(lock, std::chrono::duration<double>(TICK),
+                                [this] { return stopping || !commands.empty(); });
+    else if (board && input.isHolding())
+      commandAvailable.wait_until(lock, start + std::chrono::duration_cast<Clock::duration>(
+                                    std::chrono::duration<double>(input.nextRepeat())),
+                                  [this] { return stopping || !commands.empty(); });
+    else
+      commandAvailable.wait(lock, [this] { return stopping || !commands.empty(); });
+    if (stopping)
+      return;
+    pending.swap(commands);
+    working = true;
+    lock.unlock();
+
+    Clock::time_point now = Clock::now();
+    double seconds = std::chrono::duration<double>(now - start).count();
+    raised.clear();
+    for (const Command& command : pending)
+      apply(command, seconds);
+    pending.clear();
+
+    // Animations advance by the time really elapsed, however late this tick is.
+    if (ticking) {
+      ScopedTimer timer("SokoBoard::update");
+      board->update(std::chrono::duration<double>(now - last).count());
+    }
+    last = now;
+
+    // The next move starts as soon as the previous one is drawn in place.
+    // A snapshot is only published if the board changed: commands like a key release change nothing.
+    bool published = false;
+    if (board) {
+      applyInputs(seconds);
+      if (!raised.empty() || !moving.empty() || stale) {
+        publish();
+        published = true;
+        stale = false;
+      }
+    }
+
+    if (logBoard && unlogged && board && !board->isAnimating() && input.pending() == 0) {
+      std::cout << board->toString() << std::endl;
+      unlogged = false;
+    }
+
+    lock.lock();
+    events.insert(events.end(), raised.begin(), raised.end());
+    working = false;
+    animating = !moving.empty();
+    if (!animating && commands.empty())
+      idle.notify_all();
+    std::function<void()> listener = publishListener;
+    lock.unlock();
+    if (published && listener)
+      listener();
+    lock.lock();
+  }
+}
+
+void Simulation::apply(const Command& command, double now) {
+  if (command.type == COMMAND_LOAD) {
+    // Inputs meant for the previous board are dropped.
+    input.clear();
+    std::shared_ptr<const SokoBoard> parsed = parseLevel(command.path);
+    if (parsed == preloadedLayout) {
+      preloadedLayout.reset();
+      preloadedPath.clear();
+    }
+    level = command.level;
+
+    // The level on the board (a restart) is only put back in place; another one is copied from its parsed layout.
+    if (board && parsed == layout)
+      board->reset();
+    else {
+      layout = parsed;
+      layoutPath = command.path;
+      board.reset(new SokoBoard(*layout));
+      board->setAnimation(animationDuration, animationEasing);
+      board->subscribe([this](const SokoEvent& event) { onBoardEvent(event); });
+    }
+
+    // The only full read of the objects: from now on the board events say what changed.
+    objects.clear();
+    moving.clear();
+    for (const SokoDynamicObject& obj : board->getDynamic()) {
+      ObjectSnapshot object = {obj.getType(), obj.positionX, obj.positionY, false};
+      objects.push_back(object);
+    }
+    SokoEvent loaded = {SokoEvent::SOKO_LEVEL_LOADED, -1, SokoPosition(), SokoPosition()};
+    raised.push_back(loaded);
+    changes++;
+  }
+  else if (command.type == COMMAND_ANIMATION) {
+    animationDuration = command.duration;
+    animationEasing = command.easing;
+    if (board)
+      board->setAnimation(animationDuration, animationEasing);
+  }
+  else if (command.type == COMMAND_PRELOAD) {
+    preloadedLayout = parseLevel(command.path);
+    preloadedPath = command.path;
+    stale = true;
+  }
+  else if (command.type == COMMAND_INPUT) {
+    input.setRepeat(command.delay, command.duration);
+    coalesce = command.coalesce;
+  }
+  else if (command.type == COMMAND_MOVE)
+    input.push(command.direction);
+  else if (command.type == COMMAND_PRESS)
+    input.press(command.direction, now);
+  else if (command.type == COMMAND_RELEASE)
+    input.release(command.direction);
+  else
+    input.undo();
+}
+
+void Simulation::applyInputs(double now) {
+  Input next;
+  while (!board->isAnimating() && input.next(now, next)) {
+    unlogged = true;
+    if (next.undo) {
+      board->undo();
+      continue;
+    }
+
+    // A walk with more moves waiting goes faster, at a steady speed; its last step eases as set.
+    unsigned waiting = input.pending();
+    if (coalesce && waiting > 0)
+      board->setAnimation(animationDuration / std::min(1 + waiting, MAX_COALESCED), EASING_LINEAR);
+    else
+      board->setAnimation(animationDuration, animationEasing);
+    board->move(next.direction);
+  }
+}
+
+std::shared_ptr<const SokoBoard> Simulation::parseLevel(const std::string& path) {
+  if (layout && path == layoutPath)
+    return layout;
+  if (preloadedLayout && path == preloadedPath)
+    return preloadedLayout;
+  ScopedTimer timer("Simulation::parseLevel");
+  return std::make_shared<const SokoBoard>(path);
+}
+
+void Simulation::onBoardEvent(const SokoEvent& event) {
+  raised.push_back(event);
+  changes++;
+  if (event.type == SokoEvent::SOKO_PLAYER_MOVED || event.type == SokoEvent::SOKO_BOX_MOVED) {
+    if (std::find(moving.begin(), moving.end(), event.object) == moving.end())
+      moving.push_back(event.object);
+  }
+  else if (event.type == SokoEvent::SOKO_BOX_ENTERED_TARGET || event.type == SokoEvent::SOKO_BOX_LEFT_TARGET)
+    objects[event.object].onTarget = event.type == SokoEvent::SOKO_BOX_ENTERED_TARGET;
+}
+
+void Simulation::publish() {
+  // Objects are only read again while they move (an undo moves them without animation: one read).
+  const std::vector<SokoDynamicObject>& dynamic = board->getDynamic();
+  for (size_t i = 0; i < moving.size(); ) {
+    const SokoDynamicObject& obj = dynamic[moving[i]];
+    objects[moving[i]].x = obj.positionX;
+    objects[moving[i]].y = obj.positionY;
+    if (obj.isAnimating())
+      i++;
+    else {
+      moving[i] = moving.back();
+      moving.pop_back();
+    }
+  }
+
+  BoardSnapshot& next = snapshots.back();
+  next.level = level;
+  next.layout = layout;
+  next.nextLayout = preloadedLayout;
+  next.objects = objects;
+  next.moves = board->getNumberOfMoves();
+  next.unresolvedLightBoxes = board->getNumberOfUnresolvedLightBoxes();
+  next.unresolvedHeavyBoxes = board->getNumberOfUnresolvedHeavyBoxes();
+  next.animating = !moving.empty();
+  next.finished = next.unresolvedLightBoxes + next.unresolvedHeavyBoxes == 0 && !next.animating;
+  next.changes = changes;
+  snapshots.publish();
+}
+
+}
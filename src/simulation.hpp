@@ -0,0 +1,219 @@
+#ifndef _SIMULATION_H_
+#define _SIMULATION_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "input_queue.hpp"
+#include "soko_board.hpp"
+#include "triple_buffer.hpp"
+
+namespace Sokoban {
+  /// A dynamic object as the render thread sees it: type, animated position and whether it is on a target.
+  struct ObjectSnapshot {
+    SokoObject::Type type;
+    double x, y;
+    bool onTarget;
+  };
+
+  /// Immutable state of the board at one simulation tick.
+  struct BoardSnapshot {
+    /// Level the board was loaded for (0: none yet).
+    unsigned level = 0;
+
+    /// The board as it was loaded, for its static objects. Shared by every snapshot of the level.
+    std::shared_ptr<const SokoBoard> layout;
+
+    /// The board preloaded as the next level, if any, so its rendering can be prepared ahead.
+    std::shared_ptr<const SokoBoard> nextLayout;
+
+    std::vector<ObjectSnapshot> objects;
+    unsigned moves = 0;
+    unsigned unresolvedLightBoxes = 0;
+    unsigned unresolvedHeavyBoxes = 0;
+    bool animating = false;
+    bool finished = false;
+
+    /// Number of board events so far, over every level: unchanged means no object, counter or target changed.
+    unsigned changes = 0;
+  };
+
+  /**
+  Runs the game logic on its own thread.
+
+  The main thread queues commands (moves, undo, level loads) without waiting
+  for them; the simulation thread applies them, advances the animations in
+  real time and publishes a BoardSnapshot through a triple buffer after every
+  change. Moves and undos wait in an InputQueue until the previous move is
+  done animating, so the board is at most one move ahead of what is drawn and
+  no animation is cut short. The snapshot follows the events of the board: only the objects it
+  says moved are read again. Rendering only reads the latest snapshot, so a slow frame never
+  delays input and a burst of input never stalls a frame.
+  */
+  class Simulation {
+    public:
+      /// Start the simulation thread. With @logBoard, the board is logged whenever it comes to rest with no move waiting.
+      explicit Simulation(bool logBoard = false);
+
+      /// Stop the simulation thread. Pending commands are dropped.
+      ~Simulation();
+
+      /// Queue loading the board in @path, published as @level. The file is not read again if it is the level
+      /// preloaded or the one already on the board (a restart, which just resets it).
+      void loadLevel(unsigned level, const std::string& path);
+
+      /// Queue parsing the board in @path ahead, so loading it later costs nothing. It is published as the next layout until then.
+      void preloadLevel(const std::string& path);
+
+      /// Queue a character move to @direction.
+      void move(Direction direction);
+
+      /// Queue a character move to @direction, repeated until release() (the key is held).
+      void press(Direction direction);
+
+      /// Stop repeating the move to @direction.
+      void release(Direction direction);
+
+      /// Queue repeating held moves after @delay seconds, then every @interval.
+      /// With @coalesce, moves taken while more are waiting are animated faster, as one walk.
+      void setInput(double delay, double interval, bool coalesce);
+
+      /// Queue undoing the last move.
+      void undo();
+
+      /// Queue animating the next moves over @duration seconds (none if not positive) with @easing, on this and later levels.
+      void setAnimation(double duration, Easing easing = EASING_LINEAR);
+
+      /// Call @listener from the simulation thread after every published snapshot (eg. to wake the main loop).
+      void setPublishListener(const std::function<void()>& listener);
+
+      /// Return true if a snapshot was published since the last acquire().
+      bool hasSnapshot() const;
+
+      /// Make the latest published snapshot current. Returns false if there was none. Reader thread only.
+      bool acquire();
+
+      /// The current snapshot. Reader thread only.
+      const BoardSnapshot& snapshot() const;
+
+      /// Block until every queued command is applied and published, and nothing moves anymore.
+      void waitIdle();
+
+      /// Move the board events raised so far (and a SOKO_LEVEL_LOADED per load) to @events (cleared first).
+      void takeEvents(std::vector<SokoEvent>& events);
+
+      /// Time a move animation lasts until setAnimation() (in seconds).
+      static const double ANIMATION_DURATION;
+
+      /// Time between two animation ticks (in seconds).
+      static const double TICK;
+
+      /// Most moves a coalesced walk animates in the time of one.
+      static const unsigned MAX_COALESCED;
+
+    private:
+      Simulation(const Simulation&);
+      Simulation& operator=(const Simulation&);
+
+      typedef enum CommandType {
+        COMMAND_LOAD = 0,
+        COMMAND_MOVE = 1,
+        COMMAND_UNDO = 2,
+        COMMAND_ANIMATION = 3,
+        COMMAND_PRESS = 4,
+        COMMAND_RELEASE = 5,
+        COMMAND_INPUT = 6,
+        COMMAND_PRELOAD = 7
+      } CommandType;
+
+      struct Command {
+        CommandType type;
+        Direction direction;
+        unsigned level;
+        std::string path;
+        double duration;
+        Easing easing;
+        double delay;
+        bool coalesce;
+      };
+
+      /// Queue @command and wake the simulation thread.
+      void enqueue(const Command& command);
+
+      /// Body of the simulation thread.
+      void run();
+
+      /// Apply @command, received at @now (in seconds). Simulation thread only.
+      void apply(const Command& command, double now);
+
+      /// Return the level in @path as parsed: the layout on the board or the one preloaded, else parse it. Simulation thread only.
+      std::shared_ptr<const SokoBoard> parseLevel(const std::string& path);
+
+      /// Apply the inputs due at @now while the board is not animating. Simulation thread only.
+      void applyInputs(double now);
+
+      /// Follow the change @event of the board in the next snapshot. Simulation thread only.
+      void onBoardEvent(const SokoEvent& event);
+
+      /// Fill the back snapshot from the board and publish it. Simulation thread only.
+      void publish();
+
+      bool logBoard;
+
+      /// Owned by the simulation thread.
+      std::unique_ptr<SokoBoard> board;
+      std::shared_ptr<const SokoBoard> layout;
+      std::string layoutPath;
+      unsigned level = 0;
+
+      /// The level parsed ahead by preloadLevel() and its path, until it is loaded. Simulation thread only.
+      /// With the layout on the board, the only parsed levels kept: one played before is read again.
+      std::shared_ptr<const SokoBoard> preloadedLayout;
+      std::string preloadedPath;
+
+      /// Animation of the moves, given to every loaded board. Simulation thread only.
+      double animationDuration = ANIMATION_DURATION;
+      Easing animationEasing = EASING_LINEAR;
+
+      /// Moves and undos the board did not take yet. Simulation thread only.
+      InputQueue input;
+      bool coalesce = false;
+
+      /// Set when the board changed since it was last logged. Simulation thread only.
+      bool unlogged = false;
+
+      /// Set when the next snapshot changes with no board event (eg. a level was preloaded). Simulation thread only.
+      bool stale = false;
+
+      /// Objects as last published, the indexes of those still moving, and the changes so far. Simulation thread only.
+      std::vector<ObjectSnapshot> objects;
+      std::vector<int> moving;
+      unsigned changes = 0;
+
+      /// Events of the board not yet handed to the main thread. Simulation thread only.
+      std::vector<SokoEvent> raised;
+
+      TripleBuffer<BoardSnapshot> snapshots;
+
+      std::mutex mutex;
+      std::condition_variable commandAvailable;
+      std::condition_variable idle;
+      std::deque<Command> commands;
+      std::vector<SokoEvent> events;
+      std::function<void()> publishListener;
+      bool stopping = false;
+
+      /// Set while commands taken from the queue are not published yet, and while the board animates.
+      bool working = false;
+      bool animating = false;
+
+      std::thread thread;
+  };
+}
+
+#endif // _SIMULATION_H_
@@ -1,4 +1,5 @@
 #include "soko_board.hpp"
+#include <algorithm>
 
 namespace Sokoban {
 
@@ -39,6 +40,7 @@ SokoBoard::SokoBoard(std::string filename) :
           staticObj = SokoObject(SokoObject::EMPTY);
           dynamicObj = SokoDynamicObject(type, SokoPosition(x_now, y_now));
           dynamicBoard.push_back(dynamicObj);
+          initialPositions.push_back(SokoPosition(x_now, y_now));
         }
         staticObjLine.push_back(staticObj);
         x_now++;
@@ -60,7 +62,9 @@ SokoBoard::SokoBoard(std::string filename) :
 
 int SokoBoard::move(Direction direction) {
   int boxMovedIndex = -1, characterMoved = false;
-  SokoPosition nextPosition = dynamicBoard[characterIndex].getPosition() + direction;
+  bool wasFinished = getNumberOfUnresolvedBoxes() == 0;
+  SokoPosition characterPosition = dynamicBoard[characterIndex].getPosition();
+  SokoPosition nextPosition = characterPosition + direction;
 
   // Checking out-of-bounds on y.
   if(nextPosition.y < 0 || nextPosition.y >= staticBoard.size())
@@ -75,7 +79,7 @@ int SokoBoard::move(Direction direction) {
     SokoDynamicObject nextObj = getDynamic(nextPosition.x, nextPosition.y);
 
     if(nextObj.getType() == SokoObject::EMPTY) {
-      dynamicBoard[characterIndex].updatePosition(nextPosition);
+      animate(characterIndex, nextPosition);
       characterMoved = true;
     } else { 
       SokoPosition boxNextPosition = nextPosition + direction;
@@ -96,8 +100,8 @@ int SokoBoard::move(Direction direction) {
 
         if(boxNextObj.getType() == SokoObject::EMPTY &&
             staticBoard[boxNextPosition.y][boxNextPosition.x].getType() != SokoObject::WALL) {
-          dynamicBoard[nextObj.index].updatePosition(boxNextPosition);
-          dynamicBoard[characterIndex].updatePosition(nextPosition);
+          moveBox(nextObj.index, boxNextPosition, true);
+          animate(characterIndex, nextPosition);
           characterMoved = true;
           boxMovedIndex = nextObj.index;
         }
@@ -108,7 +112,9 @@ int SokoBoard::move(Direction direction) {
   // Saving the movement for undo
   if(characterMoved) {
     undoTree.push(SokoMovement(direction, boxMovedIndex));
-    updateUnresolvedBoxes();
+    notify(SokoEvent::SOKO_PLAYER_MOVED, characterIndex, characterPosition, nextPosition);
+    if (!wasFinished && getNumberOfUnresolvedBoxes() == 0)
+      notify(SokoEvent::SOKO_LEVEL_COMPLETED, -1, nextPosition, nextPosition);
   }
   return boxMovedIndex;
 }
@@ -119,27 +125,110 @@ int SokoBoard::undo() {
     SokoMovement last = undoTree.top();
     undoTree.pop();
 
-    // Changing character's position
-    SokoPosition previousPosition = dynamicBoard[characterIndex].getPosition() - last.direction;
-    dynamicBoard[characterIndex].resetPosition(previousPosition);
-    
     // Cheking if a box was moved and undo this movement
     if (last.boxMoved >= 0) {
       SokoPosition boxPosition = dynamicBoard[last.boxMoved].getPosition() - last.direction;
-      dynamicBoard[last.boxMoved].resetPosition(boxPosition);
+      moveBox(last.boxMoved, boxPosition, false);
     }
+
+    // Changing character's position
+    SokoPosition characterPosition = dynamicBoard[characterIndex].getPosition();
+    SokoPosition previousPosition = characterPosition - last.direction;
+    place(characterIndex, previousPosition);
+    notify(SokoEvent::SOKO_PLAYER_MOVED, characterIndex, characterPosition, previousPosition);
     return last.boxMoved;
   }
   return -1;
 }
 
+void SokoBoard::moveBox(int index, SokoPosition position, bool animate) {
+  SokoDynamicObject& box = dynamicBoard[index];
+  SokoPosition from = box.getPosition();
+  if (animate)
+    this->animate(index, position);
+  else
+    place(index, position);
+
+  // Only the two cells involved can change the counters. They are up to date before any listener is told.
+  unsigned& unresolved = box.getType() == SokoObject::LIGHT_BOX ? unresolvedLightBoxes : unresolvedHeavyBoxes;
+  bool wasOnTarget = isTarget(from), onTarget = isTarget(position);
+  if (wasOnTarget && !onTarget)
+    unresolved++;
+  else if (!wasOnTarget && onTarget)
+    unresolved--;
+
+  notify(SokoEvent::SOKO_BOX_MOVED, index, from, position);
+  if (wasOnTarget && !onTarget)
+    notify(SokoEvent::SOKO_BOX_LEFT_TARGET, index, from, position);
+  else if (!wasOnTarget && onTarget)
+    notify(SokoEvent::SOKO_BOX_ENTERED_TARGET, index, from, position);
+}
+
+void SokoBoard::reset() {
+  for (size_t i = 0; i < dynamicBoard.size(); i++)
+    dynamicBoard[i].resetPosition(initialPositions[i]);
+  animatedObjects.clear();
+  while (!undoTree.empty())
+    undoTree.pop();
+  unresolvedLightBoxes = lightBoxes;
+  unresolvedHeavyBoxes = heavyBoxes;
+}
+
+void SokoBoard::animate(int index, SokoPosition position) {
+  dynamicBoard[index].updatePosition(position, animationDuration, animationEasing);
+  if (dynamicBoard[index].isAnimating() &&
+      std::find(animatedObjects.begin(), animatedObjects.end(), index) == animatedObjects.end())
+    animatedObjects.push_back(index);
+}
+
+void SokoBoard::place(int index, SokoPosition position) {
+  dynamicBoard[index].resetPosition(position);
+  std::vector<int>::iterator it = std::find(animatedObjects.begin(), animatedObjects.end(), index);
+  if (it == animatedObjects.end())
+    return;
+  animatedObjects.erase(it);
+  if (animatedObjects.empty())
+    notify(SokoEvent::SOKO_ANIMATION_IDLE, -1, position, position);
+}
+
+void SokoBoard::setAnimation(double duration, Easing easing) {
+  animationDuration = duration;
+  animationEasing = easing;
+}
+
+bool SokoBoard::isTarget(SokoPosition position) const {
+  return staticBoard[position.y][position.x].getType() == SokoObject::TARGET;
+}
+
+unsigned SokoBoard::subscribe(const SokoListener& listener) {
+  listeners.push_back(std::make_pair(nextListenerId, listener));
+  return nextListenerId++;
+}
+
+void SokoBoard::unsubscribe(unsigned id) {
+  for (auto it = listeners.begin(); it != listeners.end(); ++it) {
+    if (it->first == id) {
+      listeners.erase(it);
+      return;
+    }
+  }
+}
+
+void SokoBoard::notify(SokoEvent::Type type, int object, SokoPosition from, SokoPosition to) {
+  if (listeners.empty())
+    return;
+  SokoEvent event = {type, object, from, to};
+  for (const auto& listener : listeners)
+    listener.second(event);
+}
+
 std::string SokoBoard::toString() {
   std::stringstream ss;
   
   ss << "INFO: Board: " << std::endl;
   int x(0), y(0);
-  for(auto line : staticBoard) {
-    for(auto obj : line) {
+  for(const auto& line : staticBoard) {
+    for(const auto& obj : line) {
       ss << " ";
       SokoDynamicObject dynObj = getDynamic(x, y);
       if(dynObj.getType() == SokoObject::EMPTY)
@@ -170,20 +259,6 @@ std::ostream& operator<<(std::ostream& os, SokoBoard& s) {
   return os;
 }
 
-void SokoBoard::updateUnresolvedBoxes() {
-  unresolvedLightBoxes = lightBoxes;
-  unresolvedHeavyBoxes = heavyBoxes;
-
-  for(SokoDynamicObject dyn : dynamicBoard) {
-    if(staticBoard[dyn.getPosition().y][dyn.getPosition().x].getType() == SokoObject::TARGET) {
-      if(dyn.getType() == SokoObject::LIGHT_BOX)
-        unresolvedLightBoxes--;
-      if(dyn.getType() == SokoObject::HEAVY_BOX)
-        unresolvedHeavyBoxes--;
-    }
-  }
-}
-
 unsigned SokoBoard::getNumberOfMoves() const {
   return undoTree.size();
 }
@@ -217,23 +292,19 @@ unsigned SokoBoard::getNumberOfUnresolvedHeavyBoxes() const {
 }
 
 bool SokoBoard::isFinished() const {
-  for (auto obj : dynamicBoard)
-    if( obj.getProgress() <= 1.0)
-      return false;
-  return getNumberOfUnresolvedBoxes() == 0;
+  return !isAnimating() && getNumberOfUnresolvedBoxes() == 0;
 }
 
-std::vector< SokoDynamicObject > SokoBoard::getDynamic() {
+const std::vector< SokoDynamicObject >& SokoBoard::getDynamic() const {
   return dynamicBoard;
 }
 
-SokoDynamicObject SokoBoard::getDynamic(int x, int y) {
-  SokoDynamicObject empty(SokoObject::EMPTY, SokoPosition(x, y));
-  for(auto obj : dynamicBoard) {
+SokoDynamicObject SokoBoard::getDynamic(int x, int y) const {
+  for(const auto& obj : dynamicBoard) {
     if(obj.getPosition().x == x && obj.getPosition().y == y)
       return obj;
   }
-  return empty;
+  return SokoDynamicObject(SokoObject::EMPTY, SokoPosition(x, y));
 }
 
 SokoObject SokoBoard::getStatic(int x, int y) const {
@@ -257,8 +328,81 @@ void SokoBoard::setDynamicIndexes() {
 }
 
 void SokoBoard::update(double t) {
-  for(int i=0; i < dynamicBoard.size(); i++)
-    dynamicBoard[i].move(t);
-  updateUnresolvedBoxes();
+  if (animatedObjects.empty())
+    return;
+  for (size_t i = 0; i < animatedObjects.size(); ) {
+    SokoDynamicObject& obj = dynamicBoard[animatedObjects[i]];
+    obj.move(t);
+    if (obj.isAnimating())
+      i++;
+    else {
+      animatedObjects[i] = animatedObjects.back();
+      animatedObjects.pop_back();
+    }
+  }
+  if (animatedObjects.empty()) {
+    SokoPosition position = dynamicBoard[characterIndex].getPosition();
+    notify(SokoEvent::SOKO_ANIMATION_IDLE, -1, position, position);
+  }
+}
+
+bool SokoBoard::isAnimating() const {
+  return !animatedObjects.empty();
+}
+
+SokoState SokoBoard::getState() const {
+  unsigned columns = 0;
+  for (const auto& line : staticBoard)
+    if (line.size() > columns)
+      columns = line.size();
+  SokoState state(columns * staticBoard.size());
+
+  // Scratch buffers are reused across calls, one set per thread, so hashing
+  // states in a loop does not hit the allocator.
+  static thread_local std::vector<bool> blocked;
+  static thread_local std::vector<unsigned> pending;
+
+  // Walls and boxes block the character.
+  blocked.assign(columns * staticBoard.size(), true);
+  for (unsigned y = 0; y < staticBoard.size(); y++)
+    for (unsigned x = 0; x < staticBoard[y].size(); x++)
+      blocked[y * columns + x] = staticBoard[y][x].getType() == SokoObject::WALL;
+
+  for (const SokoDynamicObject& obj : dynamicBoard) {
+    SokoPosition position = obj.getPosition();
+    unsigned cell = position.y * columns + position.x;
+    if (obj.getType() == SokoObject::LIGHT_BOX) {
+      state.setLightBox(cell);
+      blocked[cell] = true;
+    }
+    else if (obj.getType() == SokoObject::HEAVY_BOX) {
+      state.setHeavyBox(cell);
+      blocked[cell] = true;
+    }
+  }
+
+  // Normalize the character: flood fill its reachable area and keep the smallest cell.
+  SokoPosition start = dynamicBoard[characterIndex].getPosition();
+  unsigned smallest = start.y * columns + start.x;
+  pending.assign(1, smallest);
+  blocked[smallest] = true;
+  while (!pending.empty()) {
+    unsigned cell = pending.back();
+    pending.pop_back();
+    if (cell < smallest)
+      smallest = cell;
+
+    unsigned x = cell % columns, y = cell / columns;
+    unsigned neighbours[4] = {cell - columns, cell + 1, cell + columns, cell - 1};
+    bool inside[4] = {y > 0, x + 1 < columns, y + 1 < staticBoard.size(), x > 0};
+    for (int i = 0; i < 4; i++) {
+      if (inside[i] && !blocked[neighbours[i]]) {
+        blocked[neighbours[i]] = true;
+        pending.push_back(neighbours[i]);
+      }
+    }
+  }
+  state.setCharacterCell(smallest);
+  return state;
 }
 }
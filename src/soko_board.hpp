@@ -10,11 +10,16 @@
 #include "soko_position.hpp"
 #include "soko_object.hpp"
 #include "soko_dynamic_object.hpp"
+#include "soko_event.hpp"
+#include "soko_state.hpp"
 using namespace std;
 
 namespace Sokoban {
   /** 
   This class represents a Sokoban board.  
+
+  Every change a move or an undo makes is told to the subscribed listeners
+  as SokoEvents, so they can follow the board without polling it.
   */
   class SokoBoard {
     private:
@@ -77,12 +82,11 @@ namespace Sokoban {
       /// Returns true if this board is finished, with all boxes moved to targets.
       bool isFinished() const;
 
-      /// Returns the element in position x, y of the dynamic board.
-      std::vector< SokoDynamicObject > getDynamic();
+      /// Returns all the elements of the dynamic board.
+      const std::vector< SokoDynamicObject >& getDynamic() const;
 
-      
-      // Returns the element in position x, y of the dynamic board.
-      SokoDynamicObject getDynamic(int x, int y);
+      /// Returns the element in position x, y of the dynamic board.
+      SokoDynamicObject getDynamic(int x, int y) const;
 
       /// Returns the element in position x, y of the static board.
       SokoObject getStatic(int x, int y) const;
@@ -90,15 +94,35 @@ namespace Sokoban {
       /// Undo the last character movement.
       int undo();
 
-      /// Updates all the elements in the board for a time t
+      /// Put every object back where it was parsed and forget the moves, with no animation and no event.
+      /// Neither reads the file again nor allocates: restarting a level costs a copy of its objects.
+      void reset();
+
+      /// Advance the animations in flight by @t, in the unit of their duration. Idle elements are not visited.
       void update(double t);
 
+      /// Returns true while some element is still moving.
+      bool isAnimating() const;
+
+      /// Animate the next moves over @duration (in the unit of update(); none if not positive) with @easing.
+      /// Moves are animated over 1, linearly, until set.
+      void setAnimation(double duration, Easing easing = EASING_LINEAR);
+
+      /// Return a compact snapshot of the boxes and the (normalized) character position.
+      SokoState getState() const;
+
+      /// Call @listener with every change of this board from now on. Returns its id, for unsubscribe().
+      unsigned subscribe(const SokoListener& listener);
+
+      /// Stop calling the listener with the id @id.
+      void unsubscribe(unsigned id);
+
     private:
       unsigned unresolvedLightBoxes, unresolvedHeavyBoxes, 
         lightBoxes, heavyBoxes, targets;
 
-      /// The stack with all the movements that happened.
-      std::stack< SokoMovement > undoTree;
+      /// The stack with all the movements that happened (over a vector, so that reset() keeps its storage).
+      std::stack< SokoMovement, std::vector<SokoMovement> > undoTree;
 
       /// The character position.
       //SokoPosition characterPosition;
@@ -111,12 +135,36 @@ namespace Sokoban {
       
       /// Stores dynamic SokoObjects of a board, such as boxes and the character.
       std::vector< SokoDynamicObject > dynamicBoard;
+
+      /// Positions of the dynamic objects as parsed, for reset().
+      std::vector< SokoPosition > initialPositions;
       
       /// Stores static SokoObjects of a board, such as walls and targets.
       std::vector< std::vector< SokoObject > > staticBoard;
 
-      /// Update how many boxes are (un)resolved.
-      void updateUnresolvedBoxes();
+      /// Listeners of the changes, with their ids.
+      std::vector< std::pair<unsigned, SokoListener> > listeners;
+      unsigned nextListenerId = 0;
+
+      /// Tell the listeners about a change.
+      void notify(SokoEvent::Type type, int object, SokoPosition from, SokoPosition to);
+
+      /// Return true if there is a target at @position.
+      bool isTarget(SokoPosition position) const;
+
+      /// Move the box @index to @position (animated if @animate), counting it in or out of the targets.
+      void moveBox(int index, SokoPosition position, bool animate);
+
+      /// Indexes of the dynamic objects whose animation is in flight.
+      std::vector<int> animatedObjects;
+
+      /// Duration and easing of the next animations.
+      double animationDuration = 1.0;
+      Easing animationEasing = EASING_LINEAR;
+
+      /// Move the object @index to @position, animated or at once, keeping track of the animations in flight.
+      void animate(int index, SokoPosition position);
+      void place(int index, SokoPosition position);
 
       /// Setting all the dynamic objects indexes
       void setDynamicIndexes();
@@ -6,6 +6,25 @@
 #include <iostream>
 
 namespace Sokoban {
+  /// How an animation goes from its start (0) to its end (1).
+  typedef enum Easing {
+    /// At a constant speed.
+    EASING_LINEAR = 0,
+    /// Speeding up, then slowing down (smoothstep).
+    EASING_SMOOTH = 1,
+    /// Fast at first, slowing down to the end.
+    EASING_OUT = 2
+  } Easing;
+
+  /// Return the eased fraction of an animation at @progress (0 to 1).
+  inline double ease(Easing easing, double progress) {
+    if (easing == EASING_SMOOTH)
+      return progress * progress * (3.0 - 2.0 * progress);
+    if (easing == EASING_OUT)
+      return progress * (2.0 - progress);
+    return progress;
+  }
+
   /**
   This class represents a dynamic object that is on a sokoban board. 
   */
@@ -34,22 +53,36 @@ namespace Sokoban {
       /// The index of this object in the Dynamic board
       int index;
 
-      /// Moves the object with step. Step can be from 0.0 to 1.0
-      void move(double step) {
-        progress +=step;        
-        if(progress < 1.0) {
-          positionX = (1.0-progress) * lastPosition.x + (progress * position.x);
-          positionY = (1.0-progress) * lastPosition.y + (progress * position.y);
+      /// Advance the animation by @time, in the unit of its duration.
+      void move(double time) {
+        if (progress >= 1.0)
+          return;
+        progress += time / duration;
+        if (progress >= 1.0) {
+          progress = 1.0;
+          positionX = position.x;
+          positionY = position.y;
+        }
+        else {
+          double eased = ease(easing, progress);
+          positionX = (1.0-eased) * lastPosition.x + (eased * position.x);
+          positionY = (1.0-eased) * lastPosition.y + (eased * position.y);
         }
       };
 
-      /// Updates the position of the object
-      void updatePosition(SokoPosition newPosition) {
+      /// Updates the position of the object, animated over @duration (none if it is not positive) with @easing.
+      void updatePosition(SokoPosition newPosition, double duration = 1.0, Easing easing = EASING_LINEAR) {
+        if (duration <= 0.0) {
+          resetPosition(newPosition);
+          return;
+        }
       	positionX = position.x;
       	positionY = position.y;
       	lastPosition = position;
       	position = newPosition;
         progress = 0.0;
+        this->duration = duration;
+        this->easing = easing;
       }
 
       // Resets the position of this object to new position with no animation
@@ -61,16 +94,23 @@ namespace Sokoban {
       }
 
       /// Returns the position of this object
-      SokoPosition getPosition() {
+      SokoPosition getPosition() const {
         return position;
       }
 
       /// Returns the progress of this ojects animation
-      double getProgress() { return progress; }
+      double getProgress() const { return progress; }
+
+      /// Returns true while this object is moving to its position.
+      bool isAnimating() const { return progress < 1.0; }
 
     private:
       /// The progress of the animation
-      double progress;
+      double progress = 1.0;
+
+      /// Duration and easing of the current animation.
+      double duration = 1.0;
+      Easing easing = EASING_LINEAR;
 
       /// The position of this object on the board
       SokoPosition position;
@@ -0,0 +1,43 @@
+#ifndef _SOKO_EVENT_H_
+#define _SOKO_EVENT_H_
+
+#include <functional>
+#include "soko_position.hpp"
+
+namespace Sokoban {
+  /**
+  A change of a sokoban board, as told to its listeners. A step of the
+  character raises its box events first (if it pushed one), then
+  SOKO_PLAYER_MOVED; an undo raises the same events, backwards.
+  */
+  struct SokoEvent {
+    typedef enum Type {
+      /// A board was loaded or reset (raised by its owner: nobody listens to a board yet while it is parsed, and a reset is silent).
+      SOKO_LEVEL_LOADED = 0,
+      /// The character moved from @from to @to.
+      SOKO_PLAYER_MOVED = 1,
+      /// A box moved from @from to @to.
+      SOKO_BOX_MOVED = 2,
+      /// A box off the targets was moved onto the target at @to.
+      SOKO_BOX_ENTERED_TARGET = 3,
+      /// A box was moved off the target at @from, not onto another one.
+      SOKO_BOX_LEFT_TARGET = 4,
+      /// The last unresolved box reached a target.
+      SOKO_LEVEL_COMPLETED = 5,
+      /// The last animation in flight ended: nothing moves until the next move.
+      SOKO_ANIMATION_IDLE = 6
+    } Type;
+
+    Type type;
+
+    /// Index of the object in SokoBoard::getDynamic(), or -1.
+    int object;
+
+    SokoPosition from, to;
+  };
+
+  /// Called with every change of a board it subscribed to.
+  typedef std::function<void(const SokoEvent&)> SokoListener;
+}
+
+#endif // _SOKO_EVENT_H_
@@ -0,0 +1,193 @@
+#include "soko_state.hpp"
+
+namespace Sokoban {
+
+namespace {
+  const std::uint8_t RAW_ENCODING = 0;
+  const std::uint8_t DELTA_ENCODING = 1;
+
+  std::size_t words(unsigned cells) {
+    return std::size_t((std::uint64_t(cells) + 63) / 64);
+  }
+
+  void putVarint(std::vector<std::uint8_t>& out, std::uint64_t value) {
+    while (value >= 0x80) {
+      out.push_back(std::uint8_t(value | 0x80));
+      value >>= 7;
+    }
+    out.push_back(std::uint8_t(value));
+  }
+
+  bool getVarint(const std::vector<std::uint8_t>& in, std::size_t& pos, std::uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      if (pos >= in.size())
+        return false;
+      std::uint8_t byte = in[pos++];
+      value |= std::uint64_t(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  /// Write the indexes of the set bits as gaps from the previous one.
+  void putDeltas(std::vector<std::uint8_t>& out, const std::vector<std::uint64_t>& bits, unsigned cells) {
+    std::vector<unsigned> set;
+    for (unsigned cell = 0; cell < cells; ++cell)
+      if (bits[cell / 64] >> (cell % 64) & 1)
+        set.push_back(cell);
+
+    putVarint(out, set.size());
+    unsigned previous = 0;
+    for (unsigned cell : set) {
+      putVarint(out, cell - previous);
+      previous = cell;
+    }
+  }
+
+  bool getDeltas(const std::vector<std::uint8_t>& in, std::size_t& pos, std::vector<std::uint64_t>& bits, unsigned cells) {
+    std::uint64_t count, gap, cell = 0;
+    if (!getVarint(in, pos, count))
+      return false;
+    for (std::uint64_t i = 0; i < count; ++i) {
+      if (!getVarint(in, pos, gap))
+        return false;
+      cell += gap;
+      if (gap > cells || cell >= cells || cell / 64 >= bits.size())
+        return false;
+      bits[cell / 64] |= std::uint64_t(1) << (cell % 64);
+    }
+    return true;
+  }
+
+  void putWords(std::vector<std::uint8_t>& out, const std::vector<std::uint64_t>& bits) {
+    for (std::uint64_t word : bits)
+      for (unsigned byte = 0; byte < 8; ++byte)
+        out.push_back(std::uint8_t(word >> (8 * byte)));
+  }
+
+  bool getWords(const std::vector<std::uint8_t>& in, std::size_t& pos, std::vector<std::uint64_t>& bits) {
+    if (in.size() - pos < 8 * bits.size())
+      return false;
+    for (std::uint64_t& word : bits) {
+      word = 0;
+      for (unsigned byte = 0; byte < 8; ++byte)
+        word |= std::uint64_t(in[pos++]) << (8 * byte);
+    }
+    return true;
+  }
+
+  std::uint64_t mix(std::uint64_t h, std::uint64_t value) {
+    // hash_combine step followed by a murmur3 finalizer round.
+    h ^= value + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+  }
+}
+
+SokoState::SokoState() :
+  cells(0),
+  characterCell(0) {}
+
+SokoState::SokoState(unsigned cells) :
+  cells(cells),
+  characterCell(0),
+  lightBoxes(words(cells), 0),
+  heavyBoxes(words(cells), 0) {}
+
+unsigned SokoState::getNumberOfCells() const {
+  return cells;
+}
+
+unsigned SokoState::getCharacterCell() const {
+  return characterCell;
+}
+
+void SokoState::setCharacterCell(unsigned cell) {
+  characterCell = cell;
+}
+
+bool SokoState::hasLightBox(unsigned cell) const {
+  return lightBoxes[cell / 64] >> (cell % 64) & 1;
+}
+
+bool SokoState::hasHeavyBox(unsigned cell) const {
+  return heavyBoxes[cell / 64] >> (cell % 64) & 1;
+}
+
+void SokoState::setLightBox(unsigned cell) {
+  lightBoxes[cell / 64] |= std::uint64_t(1) << (cell % 64);
+}
+
+void SokoState::setHeavyBox(unsigned cell) {
+  heavyBoxes[cell / 64] |= std::uint64_t(1) << (cell % 64);
+}
+
+std::size_t SokoState::hash() const {
+  std::uint64_t h = mix(cells, characterCell);
+  for (std::uint64_t word : lightBoxes)
+    h = mix(h, word);
+  for (std::uint64_t word : heavyBoxes)
+    h = mix(h, ~word);
+  return std::size_t(h);
+}
+
+std::vector<std::uint8_t> SokoState::serialize(bool deltaCompressed) const {
+  std::vector<std::uint8_t> out;
+  putVarint(out, cells);
+  putVarint(out, characterCell);
+  if (deltaCompressed) {
+    out.push_back(DELTA_ENCODING);
+    putDeltas(out, lightBoxes, cells);
+    putDeltas(out, heavyBoxes, cells);
+  }
+  else {
+    out.push_back(RAW_ENCODING);
+    putWords(out, lightBoxes);
+    putWords(out, heavyBoxes);
+  }
+  return out;
+}
+
+bool SokoState::deserialize(const std::vector<std::uint8_t>& bytes, SokoState& state) {
+  std::size_t pos = 0;
+  std::uint64_t cells, characterCell;
+  if (!getVarint(bytes, pos, cells) || !getVarint(bytes, pos, characterCell) || pos >= bytes.size())
+    return false;
+  // Checked before anything is allocated for the board. An empty state has its character on cell 0.
+  if (cells > MAX_CELLS || (characterCell >= cells && characterCell != 0))
+    return false;
+  if (bytes[pos] == RAW_ENCODING && bytes.size() - pos - 1 < 16 * words(cells))
+    return false;
+
+  SokoState result(cells);
+  result.characterCell = characterCell;
+  std::uint8_t encoding = bytes[pos++];
+  bool ok;
+  if (encoding == DELTA_ENCODING)
+    ok = getDeltas(bytes, pos, result.lightBoxes, result.cells) && getDeltas(bytes, pos, result.heavyBoxes, result.cells);
+  else if (encoding == RAW_ENCODING)
+    ok = getWords(bytes, pos, result.lightBoxes) && getWords(bytes, pos, result.heavyBoxes);
+  else
+    ok = false;
+
+  if (ok && pos == bytes.size()) {
+    state = result;
+    return true;
+  }
+  return false;
+}
+
+bool SokoState::operator==(const SokoState& other) const {
+  return cells == other.cells && characterCell == other.characterCell &&
+    lightBoxes == other.lightBoxes && heavyBoxes == other.heavyBoxes;
+}
+
+bool SokoState::operator!=(const SokoState& other) const {
+  return !(*this == other);
+}
+
+}
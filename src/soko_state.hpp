@@ -0,0 +1,83 @@
+#ifndef _SOKO_STATE_H_
+#define _SOKO_STATE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Sokoban {
+  /**
+  This class represents a compact, hashable snapshot of the dynamic part of a sokoban board.
+
+  Boxes are stored as one bit per board cell (cell index = row * columns + column),
+  with light and heavy boxes kept in separate bitsets. The character is stored as its
+  normalized cell: the smallest cell index it can reach without pushing any box, so two
+  states that only differ by a walk of the character compare equal.
+  */
+  class SokoState {
+    public:
+      /// Constructs an empty SokoState.
+      SokoState();
+
+      /// Constructs an empty SokoState for a board with @cells cells.
+      explicit SokoState(unsigned cells);
+
+      /// Return the number of cells this state was built for.
+      unsigned getNumberOfCells() const;
+
+      /// Return the normalized cell of the character.
+      unsigned getCharacterCell() const;
+
+      /// Set the normalized cell of the character.
+      void setCharacterCell(unsigned cell);
+
+      /// Return true if there is a light box on @cell.
+      bool hasLightBox(unsigned cell) const;
+
+      /// Return true if there is a heavy box on @cell.
+      bool hasHeavyBox(unsigned cell) const;
+
+      /// Put a light box on @cell.
+      void setLightBox(unsigned cell);
+
+      /// Put a heavy box on @cell.
+      void setHeavyBox(unsigned cell);
+
+      /// Return a 64-bit hash of this state.
+      std::size_t hash() const;
+
+      /// Serialize this state to bytes. If @deltaCompressed, box cells are written as varint gaps.
+      std::vector<std::uint8_t> serialize(bool deltaCompressed = true) const;
+
+      /// Build a state back from the bytes produced by serialize(). Returns false on malformed input,
+      /// including boards of more than MAX_CELLS cells and cells past the end of the board.
+      static bool deserialize(const std::vector<std::uint8_t>& bytes, SokoState& state);
+
+      /// Largest board deserialize() accepts, in cells (4096 x 4096).
+      static const unsigned MAX_CELLS = 1u << 24;
+
+      bool operator==(const SokoState& other) const;
+      bool operator!=(const SokoState& other) const;
+
+    private:
+      /// Number of cells of the board this state belongs to.
+      unsigned cells;
+
+      /// The normalized character cell.
+      unsigned characterCell;
+
+      /// One bit per cell for light boxes.
+      std::vector<std::uint64_t> lightBoxes;
+
+      /// One bit per cell for heavy boxes.
+      std::vector<std::uint64_t> heavyBoxes;
+  };
+
+  /// Hash functor, so SokoState can be used as a key of unordered containers.
+  struct SokoStateHash {
+    std::size_t operator()(const SokoState& state) const { return state.hash(); }
+  };
+}
+
+#endif // _SOKO_STATE_H_
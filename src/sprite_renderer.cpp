@@ -0,0 +1,226 @@
+#include "sprite_renderer.hpp"
+#include "gui.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Sokoban {
+  namespace {
+    /// Create the sprite of @path from the image decoded by @loader, else from @bundle or the disk.
+    SDL_Texture* takeSprite(SDL_Renderer* windowRenderer, const char* path, AssetLoader* loader, const AssetBundle* bundle) {
+      Image image;
+      if (loader != NULL && loader->takeImage(path, image)) {
+        MipLevel level;
+        level.width = image.width;
+        level.height = image.height;
+        level.pixels = image.pixels.data();
+        return createTexture(windowRenderer, level);
+      }
+      return loadTexture(windowRenderer, path, bundle);
+    }
+  }
+
+  const char* const SpriteRenderer::FLOOR_PATH = "assets/floor.jpg";
+  const char* const SpriteRenderer::WALL_PATH = "assets/wall_top.jpg";
+  const char* const SpriteRenderer::TARGET_PATH = "assets/x.png";
+  const char* const SpriteRenderer::CHARACTER_PATH = "assets/claudio.jpg";
+  const char* const SpriteRenderer::LIGHT_BOX_PATH = "assets/wood.png";
+  const char* const SpriteRenderer::HEAVY_BOX_PATH = "assets/stone.png";
+
+  void SpriteRenderer::requestTextures(AssetLoader& loader, const AssetBundle* bundle) {
+    for (const char* path : {FLOOR_PATH, WALL_PATH, TARGET_PATH, CHARACTER_PATH, LIGHT_BOX_PATH, HEAVY_BOX_PATH})
+      if (bundle == NULL || bundle->find(path, BUNDLE_IMAGE) == NULL)
+        loader.requestImage(path);
+  }
+
+  SpriteRenderer::SpriteRenderer(SDL_Renderer* windowRenderer, int screenWidth, int screenHeight, TTF_Font* windowFont,
+                                 AssetLoader* loader, const AssetBundle* bundle) :
+    windowRenderer(windowRenderer),
+    screenWidth(screenWidth),
+    screenHeight(screenHeight),
+    windowFont(windowFont),
+    bundle(bundle) {
+      floorSprite = takeSprite(windowRenderer, FLOOR_PATH, loader, bundle);
+      wallSprite = takeSprite(windowRenderer, WALL_PATH, loader, bundle);
+      targetSprite = takeSprite(windowRenderer, TARGET_PATH, loader, bundle);
+      characterSprite = takeSprite(windowRenderer, CHARACTER_PATH, loader, bundle);
+      lightBoxSprite = takeSprite(windowRenderer, LIGHT_BOX_PATH, loader, bundle);
+      heavyBoxSprite = takeSprite(windowRenderer, HEAVY_BOX_PATH, loader, bundle);
+
+      /* Opaque sprites are copied, not blended: much cheaper on the software renderer. */
+      for (SDL_Texture* sprite : {floorSprite, wallSprite, characterSprite})
+        SDL_SetTextureBlendMode(sprite, SDL_BLENDMODE_NONE);
+    }
+
+  SpriteRenderer::~SpriteRenderer() {
+    for (SDL_Texture* texture : {floorSprite, wallSprite, targetSprite, characterSprite, lightBoxSprite,
+                                 heavyBoxSprite, staticLayer.texture, nextStaticLayer.texture,
+                                 statusbar.texture, profilerBar.texture})
+      if (texture != NULL)
+        SDL_DestroyTexture(texture);
+  }
+
+  SDL_Texture* SpriteRenderer::staticSprite(SokoObject::Type type) const {
+    if (type == SokoObject::WALL)
+      return wallSprite;
+    if (type == SokoObject::TARGET)
+      return targetSprite;
+    return NULL;
+  }
+
+  void SpriteRenderer::drawStatic(const SokoBoard& layout, int x, int y, int tile) {
+    // Floor under every cell, as in the 3D mesh; walls and targets over it.
+    for (unsigned row = 0; row < layout.getNumberOfRows(); row++) {
+      for (unsigned column = 0; column < layout.getNumberOfColumns(); column++) {
+        SDL_Rect cell = {x + int(column) * tile, y + int(row) * tile, tile, tile};
+        SDL_RenderCopy(windowRenderer, floorSprite, NULL, &cell);
+        SDL_Texture* sprite = staticSprite(layout.getStatic(column, row).getType());
+        if (sprite != NULL)
+          SDL_RenderCopy(windowRenderer, sprite, NULL, &cell);
+      }
+    }
+  }
+
+  void SpriteRenderer::drawStaticLayer(StaticLayer& layer, const std::shared_ptr<const SokoBoard>& layout) {
+    layer.layout = layout;
+    if (layer.texture != NULL)
+      SDL_DestroyTexture(layer.texture);
+    layer.texture = NULL;
+
+    int cells = std::max(layout->getNumberOfRows(), layout->getNumberOfColumns());
+    layer.tile = std::min(MAX_TILE, MAX_LAYER_SIZE / std::max(cells, 1));
+    if (cells == 0 || layer.tile == 0 || !SDL_RenderTargetSupported(windowRenderer))
+      return;
+    layer.texture = SDL_CreateTexture(windowRenderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                      layout->getNumberOfColumns() * layer.tile, layout->getNumberOfRows() * layer.tile);
+    if (layer.texture == NULL || SDL_SetRenderTarget(windowRenderer, layer.texture) != 0) {
+      SDL_Log("No static layer (%s), the level is drawn every frame", SDL_GetError());
+      if (layer.texture != NULL)
+        SDL_DestroyTexture(layer.texture);
+      layer.texture = NULL;
+      return;
+    }
+    SDL_SetTextureBlendMode(layer.texture, SDL_BLENDMODE_NONE);
+    drawStatic(*layout, 0, 0, layer.tile);
+    SDL_SetRenderTarget(windowRenderer, NULL);
+  }
+
+  void SpriteRenderer::updateStaticLayer(const std::shared_ptr<const SokoBoard>& layout) {
+    if (layout == staticLayer.layout)
+      return;
+    if (layout == nextStaticLayer.layout)
+      std::swap(staticLayer, nextStaticLayer);
+    else
+      drawStaticLayer(staticLayer, layout);
+  }
+
+  void SpriteRenderer::prepare(const std::shared_ptr<const SokoBoard>& layout) {
+    if (!layout || layout == staticLayer.layout || layout == nextStaticLayer.layout)
+      return;
+    ScopedTimer timer("SpriteRenderer::prepare");
+    drawStaticLayer(nextStaticLayer, layout);
+  }
+
+  void SpriteRenderer::render(const BoardSnapshot& snapshot, const HudText& hud) {
+    SDL_SetRenderDrawColor(windowRenderer, 230, 212, 143, 255);
+    SDL_RenderClear(windowRenderer);
+
+    // The board fits over the status bar, centered, then zoomed and panned.
+    if (snapshot.layout && snapshot.layout->getNumberOfRows() > 0) {
+      ScopedTimer timer("SpriteRenderer::drawBoard");
+      updateStaticLayer(snapshot.layout);
+      const SokoBoard& layout = *snapshot.layout;
+      int rows = layout.getNumberOfRows(), columns = layout.getNumberOfColumns();
+      int height = screenHeight - screenHeight/20;
+      double tile = std::min(double(screenWidth) / columns, double(height) / rows) * scale;
+      double x = (screenWidth - columns * tile) / 2 + panX;
+      double y = (height - rows * tile) / 2 + panY;
+
+      if (staticLayer.texture != NULL) {
+        SDL_Rect board = {int(lround(x)), int(lround(y)), int(lround(columns * tile)), int(lround(rows * tile))};
+        SDL_RenderCopy(windowRenderer, staticLayer.texture, NULL, &board);
+      }
+      else
+        drawStatic(layout, lround(x), lround(y), std::max(1L, lround(tile)));
+
+      // Objects between two cells are drawn at their animated position; boxes on targets are tinted red.
+      for (const ObjectSnapshot& obj : snapshot.objects) {
+        SDL_Texture* sprite = obj.type == SokoObject::CHARACTER ? characterSprite :
+                              obj.type == SokoObject::LIGHT_BOX ? lightBoxSprite : heavyBoxSprite;
+        int left = lround(x + obj.x * tile), top = lround(y + obj.y * tile);
+        SDL_Rect cell = {left, top, int(lround(x + (obj.x + 1) * tile)) - left, int(lround(y + (obj.y + 1) * tile)) - top};
+        if (obj.onTarget)
+          SDL_SetTextureColorMod(sprite, 255, 0, 0);
+        SDL_RenderCopy(windowRenderer, sprite, NULL, &cell);
+        if (obj.onTarget)
+          SDL_SetTextureColorMod(sprite, 255, 255, 255);
+      }
+    }
+
+    // HUD: text is only rendered again when it changes.
+    {
+      ScopedTimer timer("SpriteRenderer::renderHud");
+      updateText(statusbar, hud.statusbar, SDL_Color{255, 255, 255, 255});
+      drawText(statusbar, screenHeight - screenHeight/20);
+      if (!hud.profiler.empty()) {
+        updateText(profilerBar, hud.profiler, SDL_Color{255, 255, 0, 255});
+        drawText(profilerBar, 0);
+      }
+    }
+
+    {
+      ScopedTimer timer("SDL_RenderPresent");
+      SDL_RenderPresent(windowRenderer);
+    }
+  }
+
+  void SpriteRenderer::updateText(TextSprite& sprite, const std::string& text, SDL_Color color) {
+    if (sprite.texture != NULL && sprite.text == text)
+      return;
+    if (sprite.texture != NULL)
+      SDL_DestroyTexture(sprite.texture);
+    sprite.texture = NULL;
+    sprite.text = text;
+    if (windowFont == NULL || text.empty())
+      return;
+    SDL_Surface* surface = TTF_RenderText_Blended(windowFont, text.c_str(), color);
+    if (surface == NULL) {
+      SDL_Log("Unable to render the HUD text: %s", TTF_GetError());
+      return;
+    }
+    sprite.texture = SDL_CreateTextureFromSurface(windowRenderer, surface);
+    SDL_FreeSurface(surface);
+  }
+
+  void SpriteRenderer::drawText(const TextSprite& sprite, int y) {
+    // Stretched over the whole strip, as the 3D renderer does.
+    SDL_Rect bar = {0, y, screenWidth, screenHeight/20};
+    SDL_SetRenderDrawColor(windowRenderer, 0, 0, 0, 255);
+    SDL_RenderFillRect(windowRenderer, &bar);
+    if (sprite.texture != NULL)
+      SDL_RenderCopy(windowRenderer, sprite.texture, NULL, &bar);
+  }
+
+  void SpriteRenderer::renderImage(const char* path) {
+    SDL_Texture* texture = loadTexture(windowRenderer, path, bundle);
+    SDL_RenderClear(windowRenderer);
+    SDL_RenderCopy(windowRenderer, texture, NULL, NULL);
+    SDL_RenderPresent(windowRenderer);
+    SDL_DestroyTexture(texture);
+  }
+
+  void SpriteRenderer::resize(int width, int height) {
+    this->screenWidth = width;
+    this->screenHeight = height;
+  }
+
+  void SpriteRenderer::drag(double dx, double dy, bool) {
+    // Seen from the top there is nothing to orbit: both buttons pan.
+    panX += dx;
+    panY += dy;
+  }
+
+  void SpriteRenderer::zoom(int direction) {
+    scale *= direction == 1 ? 1.05 : 0.95;
+  }
+}
@@ -0,0 +1,121 @@
+#ifndef _SPRITE_RENDERER_H_
+#define _SPRITE_RENDERER_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include "asset_bundle.hpp"
+#include "asset_loader.hpp"
+#include "renderer.hpp"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+namespace Sokoban {
+  /**
+  The 2D renderer: the board seen from the top, one sprite per cell, with the
+  window SDL_Renderer as the menu draws. Meant for machines with no usable
+  OpenGL driver, where it stays cheap even with the software SDL_Renderer.
+
+  The walls, floor and targets of a level are drawn once into a target texture
+  and copied in one call per frame; only the character and the boxes are drawn
+  on top. Dragging pans the board, the wheel zooms it.
+  */
+  class SpriteRenderer : public Renderer {
+    public:
+      /// Create the sprites with @windowRenderer. Images already decoded by @loader are taken from it, else read from @bundle or the disk.
+      /// Without a font the HUD has no text.
+      SpriteRenderer(SDL_Renderer* windowRenderer, int screenWidth, int screenHeight, TTF_Font* windowFont,
+                     AssetLoader* loader = NULL, const AssetBundle* bundle = NULL);
+
+      /// Destroy the sprites and cached layers.
+      ~SpriteRenderer();
+
+      /// Queue the decoding of every sprite missing from @bundle on @loader, ahead of the construction.
+      static void requestTextures(AssetLoader& loader, const AssetBundle* bundle = NULL);
+
+      void render(const BoardSnapshot& snapshot, const HudText& hud);
+      void prepare(const std::shared_ptr<const SokoBoard>& layout);
+      void renderImage(const char* path);
+      void resize(int width, int height);
+      void drag(double dx, double dy, bool pan);
+      void zoom(int direction);
+
+    private:
+      /// A line of text rendered once with the window font, and the string it was rendered from.
+      struct TextSprite {
+        std::string text;
+        SDL_Texture* texture = NULL;
+      };
+
+      /// The static objects of a level drawn once (NULL texture: drawn every frame instead), the layout and the edge of a cell (pixels).
+      struct StaticLayer {
+        std::shared_ptr<const SokoBoard> layout;
+        SDL_Texture* texture = NULL;
+        int tile = 0;
+      };
+
+      /// The sprite of a static object type, or NULL for none.
+      SDL_Texture* staticSprite(SokoObject::Type type) const;
+
+      /// Draw the static objects of @layout with cells of @tile pixels, from @x, @y.
+      void drawStatic(const SokoBoard& layout, int x, int y, int tile);
+
+      /// Draw them once into @layer, for @layout.
+      void drawStaticLayer(StaticLayer& layer, const std::shared_ptr<const SokoBoard>& layout);
+
+      /// Make the static layer hold @layout: the one prepared ahead, or a newly drawn one.
+      void updateStaticLayer(const std::shared_ptr<const SokoBoard>& layout);
+
+      /// Render @text into @sprite with @color, unless it already holds it.
+      void updateText(TextSprite& sprite, const std::string& text, SDL_Color color);
+
+      /// Draw @sprite stretched over the strip of the window at @y, over a black background.
+      void drawText(const TextSprite& sprite, int y);
+
+      /// The main window renderer.
+      SDL_Renderer* windowRenderer;
+
+      int screenWidth, screenHeight;
+
+      /// The window font (TTF).
+      TTF_Font* windowFont;
+
+      /// Prebuilt assets, for the images of renderImage().
+      const AssetBundle* bundle;
+
+      /// Sprites, one per image.
+      SDL_Texture* floorSprite = NULL;
+      SDL_Texture* wallSprite = NULL;
+      SDL_Texture* targetSprite = NULL;
+      SDL_Texture* characterSprite = NULL;
+      SDL_Texture* lightBoxSprite = NULL;
+      SDL_Texture* heavyBoxSprite = NULL;
+
+      /// Static objects of the current level, and of the next one when prepared ahead.
+      StaticLayer staticLayer;
+      StaticLayer nextStaticLayer;
+
+      /// Status bar and profiler line.
+      TextSprite statusbar;
+      TextSprite profilerBar;
+
+      /// Pan offset (pixels) and zoom factor of the board.
+      double panX = 0, panY = 0;
+      double scale = 1.0;
+
+      /// Largest edge of a cell in the static layer, in pixels.
+      const int MAX_TILE = 64;
+
+      /// Largest edge of the static layer, in pixels; larger levels get smaller cells.
+      const int MAX_LAYER_SIZE = 4096;
+
+      static const char* const FLOOR_PATH;
+      static const char* const WALL_PATH;
+      static const char* const TARGET_PATH;
+      static const char* const CHARACTER_PATH;
+      static const char* const LIGHT_BOX_PATH;
+      static const char* const HEAVY_BOX_PATH;
+  };
+}
+
+#endif // _SPRITE_RENDERER_H_
@@ -0,0 +1,168 @@
+#include "texture_atlas.hpp"
+#include "mipmap.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+namespace Sokoban {
+
+namespace {
+  int nextPowerOfTwo(int n) {
+    int p = 1;
+    while (p < n)
+      p *= 2;
+    return p;
+  }
+
+  /// @paths without repetitions, in order of first appearance.
+  std::vector<std::string> distinctPaths(const std::vector<std::string>& paths) {
+    std::vector<std::string> distinct;
+    for (const std::string& path : paths)
+      if (std::find(distinct.begin(), distinct.end(), path) == distinct.end())
+        distinct.push_back(path);
+    return distinct;
+  }
+}
+
+TextureAtlas::TextureAtlas() {}
+
+TextureAtlas::~TextureAtlas() {
+  if (texture != 0)
+    glDeleteTextures(1, &texture);
+}
+
+void TextureAtlas::blitTile(const Image& image, std::vector<unsigned char>& atlas, int atlasWidth,
+                            int x, int y, int tileSize, int gutter) {
+  const int content = tileSize - 2 * gutter;
+  if (image.pixels.empty() || content <= 0)
+    return;
+
+  // Bilinear resampling; pixels of the gutter clamp to the image edges.
+  for (int ty = 0; ty < tileSize; ty++) {
+    double sy = std::min(std::max((ty - gutter + 0.5) / content, 0.0), 1.0) * image.height - 0.5;
+    int y0 = std::min(std::max(int(std::floor(sy)), 0), image.height - 1);
+    int y1 = std::min(y0 + 1, image.height - 1);
+    double fy = std::min(std::max(sy - y0, 0.0), 1.0);
+
+    for (int tx = 0; tx < tileSize; tx++) {
+      double sx = std::min(std::max((tx - gutter + 0.5) / content, 0.0), 1.0) * image.width - 0.5;
+      int x0 = std::min(std::max(int(std::floor(sx)), 0), image.width - 1);
+      int x1 = std::min(x0 + 1, image.width - 1);
+      double fx = std::min(std::max(sx - x0, 0.0), 1.0);
+
+      const unsigned char* p00 = &image.pixels[4 * (y0 * image.width + x0)];
+      const unsigned char* p01 = &image.pixels[4 * (y0 * image.width + x1)];
+      const unsigned char* p10 = &image.pixels[4 * (y1 * image.width + x0)];
+      const unsigned char* p11 = &image.pixels[4 * (y1 * image.width + x1)];
+      unsigned char* out = &atlas[4 * ((y + ty) * atlasWidth + x + tx)];
+      for (int c = 0; c < 4; c++) {
+        double top = p00[c] * (1 - fx) + p01[c] * fx;
+        double bottom = p10[c] * (1 - fx) + p11[c] * fx;
+        out[c] = (unsigned char) (top * (1 - fy) + bottom * fy + 0.5);
+      }
+    }
+  }
+}
+
+std::vector<std::string> TextureAtlas::layout(const std::vector<std::string>& paths, int tileSize,
+                                              int& width, int& height) {
+  std::vector<std::string> distinct = distinctPaths(paths);
+  regions.clear();
+  width = height = 0;
+  if (distinct.empty())
+    return distinct;
+
+  // Square grid of tiles, both sides powers of two.
+  const int gutter = tileSize / 32;
+  int columns = nextPowerOfTwo(int(std::ceil(std::sqrt(double(distinct.size())))));
+  int rows = (distinct.size() + columns - 1) / columns;
+  width = columns * tileSize;
+  height = nextPowerOfTwo(rows * tileSize);
+
+  for (unsigned i = 0; i < distinct.size(); i++) {
+    int x = (i % columns) * tileSize, y = (i / columns) * tileSize;
+    AtlasRegion region = {
+      GLfloat(x + gutter) / width, GLfloat(y + gutter) / height,
+      GLfloat(x + tileSize - gutter) / width, GLfloat(y + tileSize - gutter) / height
+    };
+    regions[distinct[i]] = region;
+  }
+  return distinct;
+}
+
+void TextureAtlas::compose(TextureCache& cache, const std::vector<std::string>& paths, Image& atlas, int tileSize) {
+  std::vector<std::string> distinct = layout(paths, tileSize, atlas.width, atlas.height);
+  atlas.pixels.assign(4 * atlas.width * atlas.height, 0);
+
+  int columns = atlas.width / tileSize;
+  for (unsigned i = 0; i < distinct.size(); i++) {
+    int x = (i % columns) * tileSize, y = (i / columns) * tileSize;
+    blitTile(cache.getImage(distinct[i]), atlas.pixels, atlas.width, x, y, tileSize, tileSize / 32);
+  }
+}
+
+void TextureAtlas::bindTexture() {
+  if (texture == 0)
+    glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+void TextureAtlas::build(TextureCache& cache, const std::vector<std::string>& paths, int tileSize) {
+  Image atlas;
+  compose(cache, paths, atlas, tileSize);
+  if (atlas.pixels.empty())
+    return;
+
+  // Box filtered: its footprint stays inside the gutters for longer than a wider filter's.
+  std::vector<Image> mipmaps;
+  buildMipmaps(atlas, mipmaps, MIP_FILTER_BOX);
+  bindTexture();
+  uploadMipmaps(mipmaps);
+}
+
+bool TextureAtlas::build(const std::vector<MipLevel>& levels, const std::vector<std::string>& paths, int tileSize) {
+  int width, height;
+  layout(paths, tileSize, width, height);
+  if (levels.empty() || levels[0].width != width || levels[0].height != height) {
+    regions.clear();
+    return false;
+  }
+
+  bindTexture();
+  uploadMipmaps(levels);
+  return true;
+}
+
+std::string TextureAtlas::bundleName(const std::vector<std::string>& paths, int tileSize) {
+  // FNV-1a of the tile size and the distinct paths, in order.
+  uint64_t hash = 14695981039346656037ULL;
+  std::string key = std::to_string(tileSize);
+  for (const std::string& path : distinctPaths(paths))
+    key += "\n" + path;
+  for (char c : key) {
+    hash ^= (unsigned char) c;
+    hash *= 1099511628211ULL;
+  }
+  char name[32];
+  snprintf(name, sizeof(name), "atlas:%016llx", (unsigned long long) hash);
+  return name;
+}
+
+GLuint TextureAtlas::getTexture() const {
+  return texture;
+}
+
+AtlasRegion TextureAtlas::getRegion(const std::string& path) const {
+  return regions.at(path);
+}
+
+bool TextureAtlas::contains(const std::string& path) const {
+  return regions.count(path) != 0;
+}
+
+}
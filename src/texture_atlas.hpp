@@ -0,0 +1,74 @@
+#ifndef _TEXTURE_ATLAS_H_
+#define _TEXTURE_ATLAS_H_
+
+#include <GL/glew.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "texture_cache.hpp"
+
+namespace Sokoban {
+  /// Texture coordinates of an image inside an atlas.
+  struct AtlasRegion {
+    GLfloat u0, v0, u1, v1;
+  };
+
+  /**
+  Packs several images into one texture, so faces with different images can be
+  drawn without rebinding textures.
+
+  Every image is resampled into a square tile of the atlas, surrounded by a
+  gutter of repeated edge pixels so the smaller mipmaps do not bleed across tiles.
+  */
+  class TextureAtlas {
+    public:
+      /// Constructs an empty atlas. Call build() before use.
+      TextureAtlas();
+
+      /// Delete the atlas texture.
+      ~TextureAtlas();
+
+      /// Pack the distinct images of @paths (decoded through @cache) and upload the atlas.
+      void build(TextureCache& cache, const std::vector<std::string>& paths, int tileSize = 256);
+
+      /// Upload @levels, the prebuilt mip chain of the atlas of @paths. Returns false if its size does not match.
+      bool build(const std::vector<MipLevel>& levels, const std::vector<std::string>& paths, int tileSize = 256);
+
+      /// Pack the distinct images of @paths (decoded through @cache) into @atlas, without uploading it.
+      void compose(TextureCache& cache, const std::vector<std::string>& paths, Image& atlas, int tileSize = 256);
+
+      /// Name of the atlas of @paths in an asset bundle.
+      static std::string bundleName(const std::vector<std::string>& paths, int tileSize = 256);
+
+      /// Return the atlas texture.
+      GLuint getTexture() const;
+
+      /// Return the region of the image at @path. The image must be part of the atlas.
+      AtlasRegion getRegion(const std::string& path) const;
+
+      /// Return true if the image at @path is part of the atlas.
+      bool contains(const std::string& path) const;
+
+      /// Resample @image into the tile at (@x, @y) of @atlas (@atlasWidth pixels wide).
+      static void blitTile(const Image& image, std::vector<unsigned char>& atlas, int atlasWidth,
+            int x, int y, int tileSize, int gutter);
+
+    private:
+      TextureAtlas(const TextureAtlas&);
+      TextureAtlas& operator=(const TextureAtlas&);
+
+      /// Place the distinct images of @paths on the tile grid, filling the regions. Returns them in tile order.
+      std::vector<std::string> layout(const std::vector<std::string>& paths, int tileSize, int& width, int& height);
+
+      /// Create the texture, if needed, and bind it with the atlas parameters.
+      void bindTexture();
+
+      /// The atlas texture.
+      GLuint texture = 0;
+
+      /// Region of each packed image.
+      std::map<std::string, AtlasRegion> regions;
+  };
+}
+
+#endif // _TEXTURE_ATLAS_H_
@@ -0,0 +1,107 @@
+#include "texture_cache.hpp"
+#include "asset_bundle.hpp"
+#include "mipmap.hpp"
+#include <SOIL/SOIL.h>
+#include <algorithm>
+#include <iostream>
+
+namespace Sokoban {
+
+bool loadImage(const std::string& path, Image& image) {
+  int channels;
+  unsigned char* data = SOIL_load_image(path.c_str(), &image.width, &image.height, &channels, SOIL_LOAD_RGBA);
+  if (data == NULL) {
+    std::cout << "INFO: Unable to load image " << path << ": " << SOIL_last_result() << std::endl;
+    image = Image();
+    return false;
+  }
+  image.pixels.assign(data, data + 4 * image.width * image.height);
+  SOIL_free_image_data(data);
+  return true;
+}
+
+void uploadMipmaps(const std::vector<MipLevel>& levels) {
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, std::max(int(levels.size()) - 1, 0));
+  for (unsigned i = 0; i < levels.size(); i++)
+    glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, levels[i].width, levels[i].height, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, levels[i].pixels);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void uploadMipmaps(const std::vector<Image>& levels) {
+  std::vector<MipLevel> views(levels.size());
+  for (unsigned i = 0; i < levels.size(); i++) {
+    views[i].width = levels[i].width;
+    views[i].height = levels[i].height;
+    views[i].pixels = levels[i].pixels.data();
+  }
+  uploadMipmaps(views);
+}
+
+TextureCache::TextureCache() {}
+
+TextureCache::~TextureCache() {
+  for (auto& entry : entries)
+    if (entry.second.texture != 0)
+      glDeleteTextures(1, &entry.second.texture);
+}
+
+TextureCache::Entry& TextureCache::lookup(const std::string& path) {
+  return entries[path];
+}
+
+GLuint TextureCache::get(const std::string& path) {
+  Entry& entry = lookup(path);
+  if (entry.texture == 0) {
+    glGenTextures(1, &entry.texture);
+    glBindTexture(GL_TEXTURE_2D, entry.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    std::vector<MipLevel> levels;
+    if (entry.image.pixels.empty() && bundle != NULL && bundle->getImage(path, levels)) {
+      uploadMipmaps(levels);
+      return entry.texture;
+    }
+
+    if (entry.image.pixels.empty())
+      loadImage(path, entry.image);
+    std::vector<Image> mipmaps;
+    buildMipmaps(entry.image, mipmaps, MIP_FILTER_KAISER, true);
+    uploadMipmaps(mipmaps);
+  }
+  return entry.texture;
+}
+
+void TextureCache::setBundle(const AssetBundle* bundle) {
+  this->bundle = bundle;
+}
+
+void TextureCache::insert(const std::string& path, Image& image) {
+  Entry& entry = entries[path];
+  entry.image.width = image.width;
+  entry.image.height = image.height;
+  entry.image.pixels.swap(image.pixels);
+}
+
+const Image& TextureCache::getImage(const std::string& path) {
+  Entry& entry = lookup(path);
+  if (entry.image.pixels.empty())
+    loadImage(path, entry.image);
+  return entry.image;
+}
+
+void TextureCache::releaseImages() {
+  for (auto& entry : entries)
+    entry.second.image = Image();
+}
+
+unsigned TextureCache::size() const {
+  return entries.size();
+}
+
+}
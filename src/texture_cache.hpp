@@ -0,0 +1,84 @@
+#ifndef _TEXTURE_CACHE_H_
+#define _TEXTURE_CACHE_H_
+
+#include <GL/glew.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Sokoban {
+  /// A decoded RGBA image.
+  struct Image {
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+  };
+
+  /// A mip level of an RGBA image, whose pixels are owned elsewhere.
+  struct MipLevel {
+    int width = 0;
+    int height = 0;
+    const unsigned char* pixels = NULL;
+  };
+
+  /// Decode the image at @path into RGBA. Returns false if it could not be loaded.
+  bool loadImage(const std::string& path, Image& image);
+
+  /// Upload @levels (level 0 first) as the mip chain of the bound texture.
+  void uploadMipmaps(const std::vector<MipLevel>& levels);
+  void uploadMipmaps(const std::vector<Image>& levels);
+
+  class AssetBundle;
+
+  /**
+  Path-keyed cache of OpenGL textures: every image is decoded and uploaded
+  (with Kaiser filtered mipmaps and repeat wrapping) once, no matter how many
+  faces use it.
+  Images found in the asset bundle are uploaded from their prebuilt mip chains.
+  */
+  class TextureCache {
+    public:
+      TextureCache();
+
+      /// Delete all the cached textures.
+      ~TextureCache();
+
+      /// Return the texture of the image at @path, loading it on first use.
+      GLuint get(const std::string& path);
+
+      /// Upload images from @bundle when they are in it (NULL: always decode).
+      void setBundle(const AssetBundle* bundle);
+
+      /// Use the already decoded @image for @path instead of decoding it on first use.
+      void insert(const std::string& path, Image& image);
+
+      /// Return the decoded pixels of the image at @path, loading it on first use.
+      const Image& getImage(const std::string& path);
+
+      /// Drop the decoded pixels kept so far. Textures stay alive.
+      void releaseImages();
+
+      /// Number of distinct images loaded so far.
+      unsigned size() const;
+
+    private:
+      TextureCache(const TextureCache&);
+      TextureCache& operator=(const TextureCache&);
+
+      /// A cached image: its pixels (until released) and its texture (0 until uploaded).
+      struct Entry {
+        Image image;
+        GLuint texture = 0;
+      };
+
+      /// Find or add the entry for @path.
+      Entry& lookup(const std::string& path);
+
+      std::map<std::string, Entry> entries;
+
+      /// Bundle with prebuilt mip chains, if any.
+      const AssetBundle* bundle = NULL;
+  };
+}
+
+#endif // _TEXTURE_CACHE_H_
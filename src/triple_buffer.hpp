@@ -0,0 +1,61 @@
+#ifndef _TRIPLE_BUFFER_H_
+#define _TRIPLE_BUFFER_H_
+
+#include <atomic>
+
+namespace Sokoban {
+  /**
+  Lock-free single producer, single consumer triple buffer.
+
+  The writer fills back() and publish()es it; the reader calls update() and
+  reads front(). Neither side ever waits for the other: the writer always has
+  a free slot, and the reader always sees the latest published value (values
+  published in between are skipped). Slots are reused, so a T keeping its
+  storage (eg. a vector) does not allocate once warmed up.
+  */
+  template <typename T>
+  class TripleBuffer {
+    public:
+      TripleBuffer() : ready(2) {}
+
+      /// The slot the writer fills. Only the writer thread may touch it.
+      T& back() { return slots[backIndex]; }
+
+      /// Hand the back slot over to the reader and take a free one in exchange.
+      void publish() {
+        backIndex = ready.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX;
+      }
+
+      /// Return true if a value was published since the last update().
+      bool hasUpdate() const {
+        return (ready.load(std::memory_order_acquire) & FRESH) != 0;
+      }
+
+      /// Move the latest published value to front(). Returns false if there was none.
+      bool update() {
+        if (!hasUpdate())
+          return false;
+        frontIndex = ready.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+        return true;
+      }
+
+      /// The slot the reader reads. Only the reader thread may touch it.
+      const T& front() const { return slots[frontIndex]; }
+
+    private:
+      TripleBuffer(const TripleBuffer&);
+      TripleBuffer& operator=(const TripleBuffer&);
+
+      static const unsigned INDEX = 3;
+      static const unsigned FRESH = 4;
+
+      T slots[3];
+
+      /// Index of the slot in between the two threads, with FRESH while the reader has not taken it.
+      std::atomic<unsigned> ready;
+      unsigned backIndex = 0;
+      unsigned frontIndex = 1;
+  };
+}
+
+#endif // _TRIPLE_BUFFER_H_
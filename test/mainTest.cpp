@@ -1,7 +1,17 @@
 #include "gtest/gtest.h"
+#include "camera.hpp"
+#include "level_mesh.hpp"
+#include "mipmap.hpp"
+#include "profiler.hpp"
+#include "simulation.hpp"
 #include "soko_board.hpp"
 #include "soko_position.hpp"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 #include <iostream>
+#include <thread>
 using namespace Sokoban;
 using namespace std;
 
@@ -48,3 +58,485 @@ TEST(PositionTest, PositionTest) {
   EXPECT_EQ(s.x, sp.x - 1); 
   EXPECT_EQ(s.y, sp.y);
 }
+
+TEST_F(SokoBoardTest, StateTest) {
+  SokoState initial = bt1.getState();
+
+  /* Walking without pushing does not change the normalized state. */
+  bt1.move(RIGHT);
+  EXPECT_EQ(bt1.getState(), initial);
+  EXPECT_EQ(bt1.getState().hash(), initial.hash());
+
+  /* Pushing a box does, and undoing it restores the state. */
+  bt1.move(UP);
+  EXPECT_NE(bt1.getState(), initial);
+  bt1.undo();
+  EXPECT_EQ(bt1.getState(), initial);
+
+  /* Both encodings round trip. */
+  SokoState decoded;
+  EXPECT_TRUE(SokoState::deserialize(initial.serialize(true), decoded));
+  EXPECT_EQ(decoded, initial);
+  EXPECT_TRUE(SokoState::deserialize(initial.serialize(false), decoded));
+  EXPECT_EQ(decoded, initial);
+
+  /* Malformed input is rejected and leaves the state alone. */
+  std::vector<std::uint8_t> bytes = initial.serialize(true);
+  for (std::size_t size = 0; size < bytes.size(); size++)
+    EXPECT_FALSE(SokoState::deserialize(std::vector<std::uint8_t>(bytes.begin(), bytes.begin() + size), decoded));
+  bytes = initial.serialize(false);
+  EXPECT_FALSE(SokoState::deserialize(std::vector<std::uint8_t>(bytes.begin(), bytes.end() - 1), decoded));
+  /* Oversized boards: 2^32 - 1 cells (the word count would wrap) and just past the limit. */
+  const std::uint8_t wrapping[] = {0xFF, 0xFF, 0xFF, 0xFF, 0x0F, 0x00, 0x01, 0x01, 0x05, 0x00};
+  EXPECT_FALSE(SokoState::deserialize(std::vector<std::uint8_t>(wrapping, wrapping + 10), decoded));
+  const std::uint8_t oversized[] = {0x81, 0x80, 0x80, 0x08, 0x00, 0x01, 0x00, 0x00};
+  EXPECT_FALSE(SokoState::deserialize(std::vector<std::uint8_t>(oversized, oversized + 8), decoded));
+  /* Character past the board: 10 cells, character on cell 10. */
+  const std::uint8_t character[] = {0x0A, 0x0A, 0x01, 0x00, 0x00};
+  EXPECT_FALSE(SokoState::deserialize(std::vector<std::uint8_t>(character, character + 5), decoded));
+  /* A box delta past the end: 10 cells, boxes on cells 5 and 5 + 7. */
+  const std::uint8_t delta[] = {0x0A, 0x00, 0x01, 0x02, 0x05, 0x07, 0x00};
+  EXPECT_FALSE(SokoState::deserialize(std::vector<std::uint8_t>(delta, delta + 7), decoded));
+  EXPECT_EQ(decoded, initial);
+  const std::uint8_t valid[] = {0x0A, 0x00, 0x01, 0x02, 0x05, 0x04, 0x00};
+  EXPECT_TRUE(SokoState::deserialize(std::vector<std::uint8_t>(valid, valid + 7), decoded));
+  EXPECT_TRUE(decoded.hasLightBox(9));
+  EXPECT_TRUE(SokoState::deserialize(SokoState().serialize(), decoded));
+  EXPECT_EQ(decoded, SokoState());
+}
+
+TEST_F(SokoBoardTest, AnimationTest) {
+  EXPECT_FALSE(bt1.isAnimating());
+
+  /* A move animates until its progress reaches 1, then stops exactly on the cell. */
+  bt1.move(RIGHT);
+  EXPECT_TRUE(bt1.isAnimating());
+  bt1.update(0.6);
+  EXPECT_TRUE(bt1.isAnimating());
+  bt1.update(0.6);
+  EXPECT_FALSE(bt1.isAnimating());
+  for (const SokoDynamicObject& object : bt1.getDynamic()) {
+    EXPECT_EQ(object.positionX, object.getPosition().x);
+    EXPECT_EQ(object.positionY, object.getPosition().y);
+  }
+
+  /* The end of the last animation is told once; updating an idle board does nothing. */
+  unsigned idle = 0;
+  bt1.subscribe([&](const SokoEvent& event) { idle += event.type == SokoEvent::SOKO_ANIMATION_IDLE; });
+  bt1.setAnimation(2.0, EASING_SMOOTH);
+  bt1.move(LEFT);
+  bt1.update(1.0);
+  EXPECT_TRUE(bt1.isAnimating());
+  EXPECT_EQ(idle, 0u);
+  bt1.update(1.0);
+  bt1.update(1.0);
+  EXPECT_FALSE(bt1.isAnimating());
+  EXPECT_EQ(idle, 1u);
+
+  /* Eased curves start and end with the linear one; smoothstep is symmetric around the middle. */
+  for (Easing easing : {EASING_LINEAR, EASING_SMOOTH, EASING_OUT}) {
+    EXPECT_DOUBLE_EQ(ease(easing, 0.0), 0.0);
+    EXPECT_DOUBLE_EQ(ease(easing, 1.0), 1.0);
+  }
+  EXPECT_DOUBLE_EQ(ease(EASING_SMOOTH, 0.5), 0.5);
+  EXPECT_GT(ease(EASING_OUT, 0.5), 0.5);
+}
+
+TEST_F(SokoBoardTest, ResetTest) {
+  SokoBoard board("assets/stages/stageTest.sok");
+  SokoState initial = board.getState();
+  unsigned events = 0;
+  board.subscribe([&](const SokoEvent&) { events++; });
+
+  /* Push a box onto a target, then start over: back to the board as parsed, silently. */
+  board.move(UP);
+  board.move(UP);
+  board.move(RIGHT);
+  board.move(RIGHT);
+  EXPECT_EQ(board.getNumberOfMoves(), 4u);
+  EXPECT_EQ(board.getNumberOfUnresolvedLightBoxes(), board.getNumberOfLightBoxes() - 1);
+  EXPECT_NE(board.getState(), initial);
+  events = 0;
+  board.reset();
+  EXPECT_EQ(events, 0u);
+  EXPECT_EQ(board.getState(), initial);
+  EXPECT_EQ(board.getNumberOfMoves(), 0u);
+  EXPECT_EQ(board.getNumberOfUnresolvedLightBoxes(), board.getNumberOfLightBoxes());
+  EXPECT_FALSE(board.isAnimating());
+  for (const SokoDynamicObject& object : board.getDynamic()) {
+    EXPECT_EQ(object.positionX, object.getPosition().x);
+    EXPECT_EQ(object.positionY, object.getPosition().y);
+  }
+
+  /* The reset board plays on as a fresh one, and still tells its listeners. */
+  EXPECT_EQ(board.undo(), -1);
+  board.move(UP);
+  EXPECT_EQ(board.getNumberOfMoves(), 1u);
+  EXPECT_GT(events, 0u);
+}
+
+TEST(SokoEventTest, SokoEventTest) {
+  SokoBoard board("assets/stages/stageTest.sok");
+  board.setAnimation(0);
+  std::vector<SokoEvent::Type> types;
+  std::vector<SokoEvent> events;
+  std::vector<unsigned> unresolved;
+  unsigned id = board.subscribe([&](const SokoEvent& event) {
+    types.push_back(event.type);
+    events.push_back(event);
+    unresolved.push_back(board.getNumberOfUnresolvedBoxes());
+  });
+
+  /* A walk is one event, from cell to cell. */
+  board.move(RIGHT);
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_EQ(events[0].type, SokoEvent::SOKO_PLAYER_MOVED);
+  EXPECT_EQ(events[0].from.x, 1);
+  EXPECT_EQ(events[0].to.x, 2);
+
+  /* Pushing a box onto a target: the box events come first. */
+  board.move(RIGHT);
+  board.move(RIGHT);
+  types.clear();
+  board.move(UP);
+  ASSERT_EQ(types.size(), 3u);
+  EXPECT_EQ(types[0], SokoEvent::SOKO_BOX_MOVED);
+  EXPECT_EQ(types[1], SokoEvent::SOKO_BOX_ENTERED_TARGET);
+  EXPECT_EQ(types[2], SokoEvent::SOKO_PLAYER_MOVED);
+  EXPECT_EQ(board.getNumberOfUnresolvedLightBoxes(), 1u);
+
+  /* From a target to another one, the box stays resolved. */
+  types.clear();
+  board.move(UP);
+  ASSERT_EQ(types.size(), 2u);
+  EXPECT_EQ(types[0], SokoEvent::SOKO_BOX_MOVED);
+  EXPECT_EQ(board.getNumberOfUnresolvedLightBoxes(), 1u);
+
+  /* Undoing it leaves the target it was pushed onto, counted right away. */
+  types.clear();
+  board.undo();
+  board.undo();
+  ASSERT_EQ(types.size(), 5u);
+  EXPECT_EQ(types[3], SokoEvent::SOKO_BOX_LEFT_TARGET);
+  EXPECT_EQ(board.getNumberOfUnresolvedLightBoxes(), 2u);
+  board.move(UP);
+  board.move(UP);
+
+  /* The last box on a target completes the level. */
+  for (Direction direction : {DOWN, LEFT, LEFT, UP})
+    board.move(direction);
+  types.clear();
+  unresolved.clear();
+  board.move(RIGHT);
+  ASSERT_EQ(types.size(), 4u);
+  EXPECT_EQ(types[1], SokoEvent::SOKO_BOX_ENTERED_TARGET);
+  EXPECT_EQ(types[3], SokoEvent::SOKO_LEVEL_COMPLETED);
+  /* Listeners already see the counters of the move, from its first event. */
+  EXPECT_EQ(types[0], SokoEvent::SOKO_BOX_MOVED);
+  EXPECT_EQ(unresolved[0], 0u);
+  board.update(1.0);
+  EXPECT_TRUE(board.isFinished());
+
+  /* Nothing is told once unsubscribed. */
+  board.unsubscribe(id);
+  types.clear();
+  board.undo();
+  EXPECT_TRUE(types.empty());
+}
+
+TEST(SimulationTest, TripleBufferTest) {
+  TripleBuffer<int> buffer;
+  EXPECT_FALSE(buffer.update());
+
+  /* The reader only sees the latest value, and never shares a slot with the writer. */
+  buffer.back() = 1;
+  buffer.publish();
+  buffer.back() = 2;
+  buffer.publish();
+  EXPECT_NE(&buffer.back(), &buffer.front());
+  EXPECT_TRUE(buffer.hasUpdate());
+  EXPECT_TRUE(buffer.update());
+  EXPECT_EQ(buffer.front(), 2);
+  EXPECT_FALSE(buffer.update());
+  EXPECT_EQ(buffer.front(), 2);
+  EXPECT_NE(&buffer.back(), &buffer.front());
+
+  buffer.back() = 3;
+  buffer.publish();
+  EXPECT_TRUE(buffer.update());
+  EXPECT_EQ(buffer.front(), 3);
+}
+
+TEST(SimulationTest, SimulationTest) {
+  Simulation simulation;
+  simulation.loadLevel(1, "assets/stages/stage1.sok");
+  simulation.move(RIGHT);
+
+  /* Snapshots keep coming until the move animation is over. */
+  simulation.waitIdle();
+  EXPECT_TRUE(simulation.acquire());
+  EXPECT_FALSE(simulation.hasSnapshot());
+  const BoardSnapshot& snapshot = simulation.snapshot();
+  EXPECT_EQ(snapshot.level, 1u);
+  EXPECT_EQ(snapshot.moves, 1u);
+  EXPECT_FALSE(snapshot.animating);
+  ASSERT_TRUE(snapshot.layout != NULL);
+  EXPECT_EQ(snapshot.layout->getNumberOfMoves(), 0u);
+
+  SokoBoard board("assets/stages/stage1.sok");
+  board.move(RIGHT);
+  board.update(1.0);
+  unsigned objects = 0;
+  for (const SokoDynamicObject& object : board.getDynamic()) {
+    if (object.getType() != SokoObject::CHARACTER && object.getType() != SokoObject::LIGHT_BOX &&
+        object.getType() != SokoObject::HEAVY_BOX)
+      continue;
+    ASSERT_LT(objects, snapshot.objects.size());
+    EXPECT_EQ(snapshot.objects[objects].type, object.getType());
+    EXPECT_EQ(snapshot.objects[objects].x, object.positionX);
+    EXPECT_EQ(snapshot.objects[objects].y, object.positionY);
+    objects++;
+  }
+  EXPECT_EQ(objects, snapshot.objects.size());
+
+  std::vector<SokoEvent> events;
+  simulation.takeEvents(events);
+  ASSERT_EQ(events.size(), 3u);
+  EXPECT_EQ(events[0].type, SokoEvent::SOKO_LEVEL_LOADED);
+  EXPECT_EQ(events[1].type, SokoEvent::SOKO_PLAYER_MOVED);
+  EXPECT_EQ(events[1].to.x, events[1].from.x + 1);
+  EXPECT_EQ(events[2].type, SokoEvent::SOKO_ANIMATION_IDLE);
+
+  /* Commands changing nothing publish nothing. */
+  simulation.release(RIGHT);
+  simulation.waitIdle();
+  EXPECT_FALSE(simulation.hasSnapshot());
+
+  /* A preloaded level is published ahead, then loaded as it is: the same layout, not parsed again. */
+  simulation.preloadLevel("assets/stages/stage2.sok");
+  simulation.waitIdle();
+  EXPECT_TRUE(simulation.acquire());
+  std::shared_ptr<const SokoBoard> next = simulation.snapshot().nextLayout;
+  ASSERT_TRUE(next != NULL);
+  EXPECT_EQ(simulation.snapshot().level, 1u);
+  simulation.loadLevel(2, "assets/stages/stage2.sok");
+  simulation.waitIdle();
+  EXPECT_TRUE(simulation.acquire());
+  EXPECT_EQ(simulation.snapshot().level, 2u);
+  EXPECT_EQ(simulation.snapshot().layout, next);
+  EXPECT_TRUE(simulation.snapshot().nextLayout == NULL);
+
+  /* Loading it again is a restart: the same layout, the objects back in place. */
+  simulation.move(DOWN);
+  simulation.loadLevel(2, "assets/stages/stage2.sok");
+  simulation.waitIdle();
+  EXPECT_TRUE(simulation.acquire());
+  EXPECT_EQ(simulation.snapshot().layout, next);
+  EXPECT_EQ(simulation.snapshot().moves, 0u);
+
+  /* A level played before is not kept: it is parsed again, as loaded. */
+  simulation.loadLevel(1, "assets/stages/stage1.sok");
+  simulation.waitIdle();
+  EXPECT_TRUE(simulation.acquire());
+  EXPECT_EQ(simulation.snapshot().level, 1u);
+  ASSERT_TRUE(simulation.snapshot().layout != NULL);
+  EXPECT_NE(simulation.snapshot().layout, next);
+  EXPECT_EQ(simulation.snapshot().layout->getNumberOfMoves(), 0u);
+  EXPECT_EQ(simulation.snapshot().moves, 0u);
+}
+
+TEST(SimulationTest, InputQueueTest) {
+  InputQueue input;
+  input.setRepeat(0.25, 0.1);
+  Input next;
+  EXPECT_FALSE(input.next(0.0, next));
+
+  /* Inputs come out in order; a held key only repeats once nothing is queued and its time has come. */
+  input.press(RIGHT, 0.0);
+  input.undo();
+  EXPECT_EQ(input.pending(), 2u);
+  ASSERT_TRUE(input.next(0.0, next));
+  EXPECT_FALSE(next.undo);
+  EXPECT_EQ(next.direction, RIGHT);
+  ASSERT_TRUE(input.next(0.0, next));
+  EXPECT_TRUE(next.undo);
+  EXPECT_FALSE(input.next(0.2, next));
+  ASSERT_TRUE(input.next(0.3, next));
+  EXPECT_EQ(next.direction, RIGHT);
+  EXPECT_EQ(input.pending(), 1u);
+
+  /* Repeats never pile up: a late board gets one move, not the ones it missed. */
+  ASSERT_TRUE(input.next(1.0, next));
+  EXPECT_FALSE(input.next(1.05, next));
+
+  /* Releasing another key keeps walking; releasing the held one stops. */
+  input.release(UP);
+  EXPECT_TRUE(input.isHolding());
+  input.release(RIGHT);
+  EXPECT_FALSE(input.isHolding());
+  EXPECT_FALSE(input.next(2.0, next));
+  EXPECT_EQ(input.pending(), 0u);
+
+  input.push(LEFT);
+  input.clear();
+  EXPECT_FALSE(input.next(2.0, next));
+}
+
+TEST(ProfilerTest, ProfilerTest) {
+  Profiler& profiler = Profiler::instance();
+
+  /* Percentiles of 1..100 ms. */
+  for (unsigned i = 1; i <= 100; i++)
+    profiler.record("ProfilerTest::percentiles", profiler.now(), i * 1000);
+  ProfileStatistics statistics = profiler.statistics("ProfilerTest::percentiles", 1000);
+  EXPECT_EQ(statistics.count, 100u);
+  EXPECT_DOUBLE_EQ(statistics.p50, 51.0);
+  EXPECT_DOUBLE_EQ(statistics.p95, 96.0);
+  EXPECT_DOUBLE_EQ(statistics.p99, 100.0);
+  EXPECT_EQ(profiler.statistics("ProfilerTest::percentiles", 10).count, 10u);
+  EXPECT_DOUBLE_EQ(profiler.statistics("ProfilerTest::percentiles", 10).p50, 96.0);
+
+  /* Writers on several threads never lose a sample while the ring has room. */
+  std::vector<ProfileSample> before, after;
+  profiler.collect(before);
+  std::vector<std::thread> writers;
+  for (int t = 0; t < 4; t++)
+    writers.push_back(std::thread([] {
+      for (int i = 0; i < 1000; i++)
+        ScopedTimer timer("ProfilerTest::threads");
+    }));
+  for (std::thread& writer : writers)
+    writer.join();
+  profiler.collect(after);
+  unsigned threaded = 0;
+  for (const ProfileSample& sample : after)
+    if (std::string(sample.name) == "ProfilerTest::threads")
+      threaded++;
+  EXPECT_EQ(threaded, 4000u);
+  EXPECT_EQ(after.size(), std::min<size_t>(before.size() + 4000, Profiler::CAPACITY));
+
+  /* The trace holds one complete event per sample. */
+  ASSERT_TRUE(profiler.writeTrace("profiler_test_trace.json"));
+  std::ifstream trace("profiler_test_trace.json");
+  std::stringstream contents;
+  contents << trace.rdbuf();
+  std::string json = contents.str();
+  EXPECT_EQ(json.find("{\"traceEvents\":["), 0u);
+  unsigned events = 0;
+  for (size_t at = json.find("\"ph\":\"X\""); at != std::string::npos; at = json.find("\"ph\":\"X\"", at + 1))
+    events++;
+  EXPECT_EQ(events, after.size());
+  std::remove("profiler_test_trace.json");
+}
+
+TEST_F(SokoBoardTest, LevelMeshTest) {
+  const GLuint floor[6] = {1, 2, 3, 3, 3, 3};
+  const GLuint wall[6] = {1, 1, 3, 3, 3, 3};
+  const GLuint target[6] = {1, 4, 4, 4, 4, 4};
+  MeshFaces faces;
+  LevelMesh::generate(bt1, floor, wall, target, faces);
+
+  /* Tops cover every cell exactly once; no bottoms are emitted. */
+  double topArea = 0;
+  unsigned quads = 0;
+  for (const auto& entry : faces) {
+    for (unsigned i = 0; i < entry.second.size(); i += 4) {
+      const MeshVertex* v = &entry.second[i];
+      EXPECT_NE(v[0].normal[2], -1.0);
+      if (v[0].normal[2] == 1.0)
+        topArea += fabs((v[2].position[0] - v[0].position[0]) * (v[2].position[1] - v[0].position[1]));
+      quads++;
+    }
+  }
+  EXPECT_DOUBLE_EQ(topArea, bt1.getNumberOfRows() * bt1.getNumberOfColumns() * 0.25);
+
+  /* Far fewer quads than six per cube. */
+  EXPECT_LT(quads, 6 * bt1.getNumberOfRows() * bt1.getNumberOfColumns() / 4);
+
+  /* The board fits in one chunk, which then holds the same faces. */
+  MeshFaces chunk;
+  LevelMesh::generateChunk(bt1, floor, wall, target, 0, 0, chunk);
+  EXPECT_EQ(chunk.size(), faces.size());
+  for (const auto& entry : faces)
+    EXPECT_EQ(chunk[entry.first].size(), entry.second.size());
+}
+
+TEST(CameraTest, CameraTest) {
+  Camera camera;
+
+  /* The default view is gluLookAt((4, 4, 4), origin, z up): the eye maps to the origin, the target to -z. */
+  const double* m = camera.getViewMatrix();
+  for (int i = 0; i < 3; i++) {
+    EXPECT_NEAR(m[i] * 4 + m[4 + i] * 4 + m[8 + i] * 4 + m[12 + i], 0.0, 1e-9);
+    EXPECT_NEAR(m[12 + i], i == 2 ? -camera.getDistance() : 0.0, 1e-9);
+  }
+
+  /* Input is only applied by update(), all at once. */
+  EXPECT_FALSE(camera.update());
+  camera.orbit(10, 0);
+  camera.orbit(10, 10000);
+  camera.zoom(1);
+  EXPECT_DOUBLE_EQ(camera.getScale(), 1.0);
+  EXPECT_TRUE(camera.update());
+  EXPECT_FALSE(camera.update());
+  EXPECT_DOUBLE_EQ(camera.getScale(), 1.05);
+  EXPECT_LT(camera.getPitch(), 90.0);
+  camera.pan(5, -3);
+  camera.update();
+
+  /* The state round trips through its serialization. */
+  Camera restored;
+  EXPECT_TRUE(Camera::deserialize(camera.serialize(), restored));
+  for (int i = 0; i < 16; i++)
+    EXPECT_DOUBLE_EQ(restored.getViewMatrix()[i], camera.getViewMatrix()[i]);
+  EXPECT_FALSE(Camera::deserialize("camera 1 2", restored));
+
+  /* The frustum keeps what is in front of the camera and culls what is behind or beside it. */
+  Camera view;
+  const float inside[2][3] = {{-1, -1, -1}, {1, 1, 1}};
+  const float behind[2][3] = {{6, 6, 6}, {7, 7, 7}};
+  const float beside[2][3] = {{-40, 30, 0}, {-39, 31, 1}};
+  EXPECT_TRUE(view.getFrustum().intersects(inside[0], inside[1]));
+  EXPECT_FALSE(view.getFrustum().intersects(behind[0], behind[1]));
+  EXPECT_FALSE(view.getFrustum().intersects(beside[0], beside[1]));
+}
+
+TEST(MipmapTest, MipmapTest) {
+  Image base;
+  base.width = 5;
+  base.height = 3;
+  base.pixels.assign(4 * 5 * 3, 200);
+
+  for (MipFilter filter : {MIP_FILTER_BOX, MIP_FILTER_KAISER}) {
+    for (bool wrap : {false, true}) {
+      vector<Image> levels;
+      buildMipmaps(base, levels, filter, wrap);
+
+      /* Non power of two sizes are halved down to 1x1, not rescaled. */
+      ASSERT_EQ(levels.size(), 3u);
+      EXPECT_EQ(levels[0].width, 5); EXPECT_EQ(levels[0].height, 3);
+      EXPECT_EQ(levels[1].width, 2); EXPECT_EQ(levels[1].height, 1);
+      EXPECT_EQ(levels[2].width, 1); EXPECT_EQ(levels[2].height, 1);
+
+      /* A flat image stays flat. */
+      for (const Image& level : levels) {
+        ASSERT_EQ(level.pixels.size(), 4u * level.width * level.height);
+        for (unsigned char value : level.pixels)
+          EXPECT_EQ(value, 200);
+      }
+    }
+  }
+
+  /* The box filter averages each 2x2 block, rounding to nearest. */
+  Image stripes;
+  stripes.width = 6;
+  stripes.height = 2;
+  for (int i = 0; i < 12; i++)
+    for (int c = 0; c < 4; c++)
+      stripes.pixels.push_back(i % 2 ? 255 : 0);
+  vector<Image> levels;
+  buildMipmaps(stripes, levels, MIP_FILTER_BOX);
+  ASSERT_EQ(levels[1].width, 3);
+  for (unsigned char value : levels[1].pixels)
+    EXPECT_EQ(value, 128);
+}
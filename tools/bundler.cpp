@@ -0,0 +1,203 @@
+/**
+Offline asset bundler: decodes the assets listed in a manifest and writes
+them to one memory-mappable bundle (see asset_bundle.hpp), so the game can
+upload and play them without decoding anything at startup.
+
+Usage: sokoban_bundler <manifest> <bundle>
+*/
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <SDL2/SDL_ttf.h>
+#include "asset_bundle.hpp"
+#include "asset_loader.hpp"
+#include "glyph_atlas.hpp"
+#include "mipmap.hpp"
+#include "texture_atlas.hpp"
+#include "texture_cache.hpp"
+
+using namespace Sokoban;
+
+namespace {
+  /// The format the game opens the mixer with.
+  const int MIXER_FREQUENCY = 44100;
+  const Uint16 MIXER_FORMAT = MIX_DEFAULT_FORMAT;
+  const int MIXER_CHANNELS = 2;
+
+  /// Collects the entries and their data, then writes the bundle.
+  class BundleWriter {
+    public:
+      /// Add an entry of @size bytes; returns where to copy its data.
+      unsigned char* add(const std::string& name, BundleEntryType type, uint32_t info0, uint32_t info1,
+                         uint32_t info2, uint64_t size) {
+        BundleEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        strncpy(entry.name, name.c_str(), sizeof(entry.name) - 1);
+        entry.type = type;
+        entry.info[0] = info0;
+        entry.info[1] = info1;
+        entry.info[2] = info2;
+        entry.offset = align(blob.size());
+        entry.size = size;
+        entries.push_back(entry);
+        blob.resize(entry.offset + size, 0);
+        return &blob[entry.offset];
+      }
+
+      /// Add the mip chain of @image, built as the game would (see TextureCache and TextureAtlas).
+      void addMipmaps(const std::string& name, const Image& image, MipFilter filter, bool wrap) {
+        std::vector<Image> levels;
+        buildMipmaps(image, levels, filter, wrap);
+        uint64_t size = 0;
+        for (const Image& level : levels)
+          size += level.pixels.size();
+        unsigned char* out = add(name, BUNDLE_IMAGE, image.width, image.height, levels.size(), size);
+        for (const Image& level : levels) {
+          memcpy(out, level.pixels.data(), level.pixels.size());
+          out += level.pixels.size();
+        }
+      }
+
+      /// Write the header, the index and the data to @path.
+      bool write(const std::string& path) {
+        BundleHeader header;
+        memcpy(header.magic, BUNDLE_MAGIC, sizeof(header.magic));
+        header.version = BUNDLE_VERSION;
+        header.entryCount = entries.size();
+        header.reserved = 0;
+
+        // Data offsets were relative to the blob until now.
+        uint64_t dataStart = align(sizeof(header) + entries.size() * sizeof(BundleEntry));
+        for (BundleEntry& entry : entries)
+          entry.offset += dataStart;
+
+        std::ofstream file(path.c_str(), std::ios::binary);
+        file.write((const char*) &header, sizeof(header));
+        file.write((const char*) entries.data(), entries.size() * sizeof(BundleEntry));
+        std::vector<char> padding(dataStart - sizeof(header) - entries.size() * sizeof(BundleEntry), 0);
+        file.write(padding.data(), padding.size());
+        file.write((const char*) blob.data(), blob.size());
+        return file.good();
+      }
+
+    private:
+      static uint64_t align(uint64_t offset) {
+        return (offset + BUNDLE_ALIGNMENT - 1) / BUNDLE_ALIGNMENT * BUNDLE_ALIGNMENT;
+      }
+
+      std::vector<BundleEntry> entries;
+      std::vector<unsigned char> blob;
+  };
+
+  /// Add the asset of one manifest line. Returns false if it could not be loaded.
+  bool addAsset(BundleWriter& writer, TextureCache& cache, const std::string& kind, std::istringstream& args) {
+    std::string path;
+    if (kind == "texture" || kind == "image") {
+      args >> path;
+      Image image;
+      if (!loadImage(path, image))
+        return false;
+      if (kind == "texture")
+        writer.addMipmaps(path, image, MIP_FILTER_KAISER, true);
+      else
+        memcpy(writer.add(path, BUNDLE_IMAGE, image.width, image.height, 1, image.pixels.size()),
+               image.pixels.data(), image.pixels.size());
+    }
+    else if (kind == "atlas") {
+      std::vector<std::string> paths;
+      while (args >> path)
+        paths.push_back(path);
+      TextureAtlas atlas;
+      Image image;
+      atlas.compose(cache, paths, image);
+      if (image.pixels.empty())
+        return false;
+      writer.addMipmaps(TextureAtlas::bundleName(paths), image, MIP_FILTER_BOX, false);
+    }
+    else if (kind == "sound") {
+      args >> path;
+      Sound sound;
+      if (!loadSound(path, MIXER_FREQUENCY, MIXER_FORMAT, MIXER_CHANNELS, sound))
+        return false;
+      memcpy(writer.add(path, BUNDLE_SOUND, MIXER_FREQUENCY, MIXER_FORMAT, MIXER_CHANNELS, sound.samples.size()),
+             sound.samples.data(), sound.samples.size());
+    }
+    else if (kind == "font") {
+      int size = 0;
+      args >> path >> size;
+      TTF_Font* font = TTF_OpenFont(path.c_str(), size);
+      if (font == NULL)
+        return false;
+      GlyphAtlas glyphAtlas;
+      Image image;
+      bool ok = glyphAtlas.rasterize(font, image);
+      if (ok) {
+        const std::vector<GlyphAtlas::Glyph>& glyphs = glyphAtlas.getGlyphs();
+        uint64_t tableSize = glyphs.size() * sizeof(GlyphAtlas::Glyph);
+        unsigned char* out = writer.add(GlyphAtlas::bundleName(font), BUNDLE_FONT, image.width, image.height,
+                                        glyphAtlas.getHeight(), tableSize + image.pixels.size());
+        memcpy(out, glyphs.data(), tableSize);
+        memcpy(out + tableSize, image.pixels.data(), image.pixels.size());
+      }
+      TTF_CloseFont(font);
+      return ok;
+    }
+    else if (kind == "file") {
+      args >> path;
+      std::ifstream file(path.c_str(), std::ios::binary);
+      if (!file.is_open())
+        return false;
+      std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+      memcpy(writer.add(path, BUNDLE_FILE, 0, 0, 0, bytes.size()), bytes.data(), bytes.size());
+    }
+    else {
+      std::cout << "INFO: Unknown asset kind " << kind << std::endl;
+      return false;
+    }
+    return true;
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    std::cout << "Usage: " << argv[0] << " <manifest> <bundle>" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::ifstream manifest(argv[1]);
+  if (!manifest.is_open()) {
+    std::cout << "Unable to open the manifest " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (TTF_Init() == -1) {
+    std::cout << "SDL_ttf could not initialize: " << TTF_GetError() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Assets that fail to load are left out: the game decodes them itself, or reports them.
+  BundleWriter writer;
+  TextureCache cache;
+  std::string line;
+  while (std::getline(manifest, line)) {
+    std::istringstream args(line);
+    std::string kind;
+    if (!(args >> kind) || kind[0] == '#')
+      continue;
+    if (!addAsset(writer, cache, kind, args))
+      std::cout << "INFO: Skipping " << line << std::endl;
+  }
+  TTF_Quit();
+
+  if (!writer.write(argv[2])) {
+    std::cout << "Unable to write the bundle " << argv[2] << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}